@@ -0,0 +1,67 @@
+#!/usr/bin/env bash
+# -----------------------------------------------------------------------------
+#
+# Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+# BioDynaMo collaboration. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+#
+# See the LICENSE file distributed with this work for details.
+# See the NOTICE file distributed with this work for additional information
+# regarding copyright ownership.
+#
+# -----------------------------------------------------------------------------
+#
+# Runs the models of all examples without visualization for a number of
+# scale factors and appends their performance reports (one JSON line per
+# example and scale factor) to a single file. Examples that have not been
+# built yet are built first. Before them, the diffusion kernels of the
+# examples are checked against the engine's (see src/bench_stencil.h), and
+# the suite fails if they deviate.
+#
+# Usage: ./run_suite.sh [report file] (default: suite.jsonl)
+# Environment variables:
+#   SCALES    scale factors of the number of agents (default: "1 10 100")
+#   STEPS     number of time steps of every run (default: that of each example)
+#   EXAMPLES  examples to run (default: "ex01 ... ex11")
+#   CHECK     check the diffusion kernels first (default: 1, 0 skips it)
+#
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+REPORT="$(realpath -m "${1:-suite.jsonl}")"
+SCALES="${SCALES:-1 10 100}"
+STEPS="${STEPS:-0}"
+EXAMPLES="${EXAMPLES:-$(cd "${ROOT}" && ls -d ex[0-9][0-9] | tr '\n' ' ')}"
+CHECK="${CHECK:-1}"
+
+if [ "${CHECK}" != "0" ]; then
+  check="${ROOT}/benchmark/build/bench_stencil"
+  if [ ! -x "${check}" ]; then
+    cmake -S "${ROOT}/benchmark" -B "${ROOT}/benchmark/build" -DCMAKE_BUILD_TYPE=Release
+    cmake --build "${ROOT}/benchmark/build" --target bench_stencil -j "$(nproc)"
+  fi
+  echo "Checking the diffusion kernels"
+  # the reference check alone, without the timed lattices
+  (cd "${ROOT}/benchmark/build" && "${check}" --max-resolution 0 > /dev/null)
+fi
+
+for ex in ${EXAMPLES}; do
+  # the executables of the examples are named ex1, ..., ex9, ex10, ex11
+  exe="${ROOT}/${ex}/build/ex$((10#${ex#ex}))"
+  if [ ! -x "${exe}" ]; then
+    cmake -S "${ROOT}/${ex}" -B "${ROOT}/${ex}/build" -DCMAKE_BUILD_TYPE=Release
+    cmake --build "${ROOT}/${ex}/build" -j "$(nproc)"
+  fi
+  for scale in ${SCALES}; do
+    echo "Running ${ex} (scale ${scale})"
+    # each run takes place in its own output folder
+    out="${ROOT}/${ex}/build/suite_x${scale}"
+    mkdir -p "${out}"
+    (cd "${out}" && "${exe}" --headless --scale "${scale}" --steps "${STEPS}" \
+                             --report "${REPORT}" > "${out}/log.txt" 2>&1)
+  done
+done
+
+echo "Reports appended to ${REPORT}"
@@ -0,0 +1,281 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef BENCH_BEHAVIORS_H_
+#define BENCH_BEHAVIORS_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+#include "biodynamo.h"
+#include "core/behavior/secretion.h"
+#include "../../ex09/src/my_cell.h"
+#include "batched_migration.h"
+#include "cell_growth.h"
+#include "cell_migration.h"
+#include "dormant_tier.h"
+#include "legacy_behaviors.h"
+
+namespace bdm {
+
+enum Substances { kCytokine };
+
+/*
+Same action as in examples "ex7" to "ex9": a cell that sticks to the domain
+boundary starts growing (and, as in example "ex7", it is frozen once grown
+if there is a dormant tier).
+*/
+struct StartGrowth {
+  DormantTier* dormant = nullptr;
+
+  void operator()(Cell* cell) const {
+    if (dormant != nullptr) {
+      cell->AddBehavior(new CellGrowth<Cell, FreezeAction>(4.0, 0.1, FreezeAction{dormant}));
+    } else {
+      cell->AddBehavior(new CellGrowth<Cell>(4.0, 0.1));
+    }
+  }
+};
+
+/*
+The migration behavior of examples "ex6" to "ex9" before...
+*/
+struct LegacyBehaviors {
+  static constexpr const char* kName = "legacy";
+
+  void Setup(Simulation*, int example) { example_ = example; }
+
+  void AddMigration(Cell* cell, real_t migration_rate, real_t propability) {
+    cell->AddBehavior(new LegacyMigration(migration_rate, propability, true, example_ > 6));
+  }
+
+  int example_ = 0;
+};
+
+/*
+...after being replaced by the statically dispatched behaviors...
+*/
+struct StaticBehaviors {
+  static constexpr const char* kName = "static";
+
+  void Setup(Simulation*, int example) { example_ = example; }
+
+  void AddMigration(Cell* cell, real_t migration_rate, real_t propability) {
+    if (example_ == 6) {
+      cell->AddBehavior(new CellMigration<Cell, BoundaryMode::kStick>(migration_rate, propability));
+    } else {
+      cell->AddBehavior(new CellMigration<Cell, BoundaryMode::kStick, StartGrowth>(migration_rate, propability));
+    }
+  }
+
+  int example_ = 0;
+};
+
+/*
+...with all cells migrating in a single batched operation instead...
+*/
+struct BatchedBehaviors {
+  static constexpr const char* kName = "batched";
+
+  void Setup(Simulation* sim, int example) {
+    if (example == 6) {
+      Schedule(sim, new BatchedMigration<BoundaryMode::kStick>());
+    } else {
+      Schedule(sim, new BatchedMigration<BoundaryMode::kStick, StartGrowth>());
+    }
+  }
+
+  void AddMigration(Cell* cell, real_t migration_rate, real_t propability) {
+    add_(cell, migration_rate, propability);
+  }
+
+  template <typename TMigration>
+  void Schedule(Simulation* sim, TMigration* migration) {
+    auto* op = new Operation("batched migration");
+    op->AddOperationImpl(kCpu, migration);
+    sim->GetScheduler()->ScheduleOp(op);
+    add_ = [migration](Cell* cell, real_t migration_rate, real_t propability) {
+      migration->Add(cell, migration_rate, propability);
+    };
+  }
+
+  std::function<void(Cell*, real_t, real_t)> add_;
+};
+
+/*
+...and with the cells frozen on the boundary moved into the dormant tier
+(examples "ex6" and "ex7" only, as the cells of "ex8" and "ex9" secrete), as
+with the opt-in command line option '--dormant-tier' of these examples,
+which changes their mechanics.
+*/
+struct DormantBehaviors {
+  static constexpr const char* kName = "dormant";
+
+  void Setup(Simulation* sim, int example) {
+    example_ = example;
+    if (example > 7) return;
+    dormant_ = new DormantTier();
+    auto* op = new Operation("dormant tier");
+    op->AddOperationImpl(kCpu, dormant_);
+    sim->GetScheduler()->ScheduleOp(op, OpType::kPostSchedule);
+    sim->GetScheduler()->SetAgentFilters({&active_});
+  }
+
+  void AddMigration(Cell* cell, real_t migration_rate, real_t propability) {
+    if (example_ == 6) {
+      cell->AddBehavior(new CellMigration<Cell, BoundaryMode::kStick, FreezeAction>(
+          migration_rate, propability, FreezeAction{dormant_}));
+    } else {
+      cell->AddBehavior(new CellMigration<Cell, BoundaryMode::kStick, StartGrowth>(
+          migration_rate, propability, StartGrowth{dormant_}));
+    }
+  }
+
+  struct ActiveFilter : public Functor<bool, Agent*> {
+    explicit ActiveFilter(const DormantBehaviors* behaviors) : behaviors(behaviors) {}
+    bool operator()(Agent* agent) override { return behaviors->dormant_->IsActive(agent); }
+    const DormantBehaviors* behaviors;
+  };
+
+  int example_ = 0;
+  DormantTier* dormant_ = nullptr;
+  ActiveFilter active_{this};
+};
+
+/*
+Sets up the model of example "ex<example>" (6 to 9) without visualization
+and returns the number of simulated steps per second.
+*/
+template <typename TBehaviors>
+inline real_t RunBehaviorScenario(CommandLineOptions* clo, int example, uint64_t steps) {
+  auto set_parameters = [](Param* param) {
+    param->use_progress_bar = false;
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound =   0.0;
+    param->max_bound = 100.0;
+    param->export_visualization = false;
+    param->calculate_gradients = false;
+    param->diffusion_method = "euler";
+    param->statistics = false;
+    param->simulation_time_step = 1.0;
+  };
+
+  Simulation sim(clo, set_parameters);
+  const Param* param = sim.GetParam();
+  TBehaviors behaviors;
+  behaviors.Setup(&sim, example);
+
+  const real_t domain_center = 0.5*(param->max_bound+param->min_bound);
+  const real_t domain_delta = 0.5*(param->max_bound-param->min_bound);
+  const Real3 center{domain_center, domain_center, domain_center};
+
+  if (example >= 8) {
+    ModelInitializer::DefineSubstance(kCytokine, "TGF", 0.0, 0.05e-3, 51);
+    ModelInitializer::AddBoundaryConditions(kCytokine, BoundaryConditionType::kNeumann,
+                                            std::make_unique<ConstantBoundaryCondition>(0));
+  }
+  if (example == 9) {
+    // the phenotype-1 cells of example "ex9" only uptake "TGF"
+    auto generate_grid_of_cells = [](const Real3& xyz) {
+      MyCell* cell = new MyCell();
+      cell->SetDiameter(4.0);
+      cell->SetDensity(10.0);
+      cell->SetPosition(xyz);
+      cell->SetPhenotype(1);
+      cell->AddBehavior(new Secretion("TGF", -0.2e-3));
+      return cell;
+    };
+    ModelInitializer::CreateAgentsRandom(domain_center-0.9*domain_delta,domain_center+0.9*domain_delta,
+                                         777, generate_grid_of_cells);
+  }
+
+  auto generate_cluster_of_cells = [&](const Real3& xyz) {
+    Cell* cell = nullptr;
+    if (example == 9) {
+      MyCell* my_cell = new MyCell();
+      my_cell->SetPhenotype(2);
+      cell = my_cell;
+    } else {
+      cell = new Cell();
+    }
+    cell->SetDiameter(2.0);
+    cell->SetDensity(1.0);
+    cell->SetPosition(xyz);
+    behaviors.AddMigration(cell, 1.0, 0.5);
+    if (example >= 8) {
+      cell->AddBehavior(new Secretion("TGF", 0.2e-3));
+    }
+    return cell;
+  };
+  const real_t radius = (example == 9 ? 0.85 : 0.90)*domain_delta;
+  ModelInitializer::CreateAgentsInSphereRndm(center, radius,
+                                             2222, generate_cluster_of_cells);
+
+  const auto start = std::chrono::steady_clock::now();
+  sim.GetScheduler()->Simulate(steps);
+  const std::chrono::duration<real_t> elapsed = std::chrono::steady_clock::now() - start;
+  return steps / elapsed.count();
+}
+
+/*
+Benchmark of the migration (and growth) behaviors of examples "ex6" to "ex9"
+before and after the statically dispatched behaviors replaced them, as well
+as with the batched migration operation and with the (opt-in) dormant tier.
+Prints the best of a few repetitions as CSV (speedups are relative to the
+legacy behaviors), e.g.:
+  ./build/bench_behaviors --steps 1000 --repeat 3
+*/
+inline int bench_behaviors(int argc, const char* argv[]) {
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<uint64_t>("steps", "1000", "Number of simulated steps per run");
+  clo.AddOption<uint64_t>("repeat", "3", "Number of runs per scenario (the best is reported)");
+  const uint64_t steps = clo.Get<uint64_t>("steps");
+  const uint64_t repeat = std::max<uint64_t>(clo.Get<uint64_t>("repeat"), 1);
+
+  auto best_of = [&](auto run) {
+    real_t best = 0.0;
+    for (uint64_t r = 0; r < repeat; ++r) best = std::max(best, run());
+    return best;
+  };
+
+  std::printf("example,steps,%s_steps_per_sec,%s_steps_per_sec,%s_steps_per_sec,"
+              "%s_steps_per_sec,%s_speedup,%s_speedup,%s_speedup\n",
+              LegacyBehaviors::kName, StaticBehaviors::kName, BatchedBehaviors::kName,
+              DormantBehaviors::kName, StaticBehaviors::kName, BatchedBehaviors::kName,
+              DormantBehaviors::kName);
+  for (int example = 6; example <= 9; ++example) {
+    const real_t legacy = best_of([&]() {
+      return RunBehaviorScenario<LegacyBehaviors>(&clo, example, steps);
+    });
+    const real_t static_dispatch = best_of([&]() {
+      return RunBehaviorScenario<StaticBehaviors>(&clo, example, steps);
+    });
+    const real_t batched = best_of([&]() {
+      return RunBehaviorScenario<BatchedBehaviors>(&clo, example, steps);
+    });
+    const real_t dormant = best_of([&]() {
+      return RunBehaviorScenario<DormantBehaviors>(&clo, example, steps);
+    });
+    std::printf("ex%02d,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", example,
+                static_cast<unsigned long long>(steps), legacy, static_dispatch, batched,
+                dormant, static_dispatch / legacy, batched / legacy, dormant / legacy);
+  }
+  return 0;
+}
+
+} // namespace bdm
+
+#endif // BENCH_BEHAVIORS_H_
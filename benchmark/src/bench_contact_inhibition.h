@@ -0,0 +1,158 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef BENCH_CONTACT_INHIBITION_H_
+#define BENCH_CONTACT_INHIBITION_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+#include "biodynamo.h"
+#include "../../ex11/src/my_contact_inhibition.h"
+#include "cell_growth_division.h"
+#include "neighbor_index.h"
+
+namespace bdm {
+
+enum class NeighborSearch { kEngine, kIndexed, kPartitioned };
+
+/*
+The parameters of the model of example "ex11" with the given number of
+phenotype-2 cells, in a domain whose volume grows with their number, so
+that their density stays the same.
+*/
+inline void SetContactInhibitionParameters(Param* param, uint64_t cells) {
+  const real_t length = 100.0 * std::max<real_t>(std::cbrt(cells / 5000.0), 1.0);
+  param->use_progress_bar = false;
+  param->bound_space = Param::BoundSpaceMode::kClosed;
+  param->min_bound = 0.0;
+  param->max_bound = length;
+  param->export_visualization = false;
+  param->statistics = false;
+  param->simulation_time_step = 1.0;
+}
+
+/*
+Sets up the model of example "ex11" with the given number of phenotype-2
+cells (randomly scattered in the domain of 'SetContactInhibitionParameters').
+The contact inhibition searches through the execution context of the
+simulation engine (kEngine), or a neighbor index either of all cells
+(kIndexed) or partitioned by phenotype (kPartitioned).
+*/
+inline void InitializeContactInhibitionModel(Simulation* sim, uint64_t cells,
+                                             NeighborSearch search) {
+  const Param* param = sim->GetParam();
+  const real_t length = param->max_bound - param->min_bound;
+
+  const real_t safe_distance = 4.0;
+  NeighborIndex* neighbors = nullptr;
+  if (search != NeighborSearch::kEngine) {
+    neighbors = search == NeighborSearch::kIndexed
+                    ? new NeighborIndex(safe_distance)
+                    : new NeighborIndex(safe_distance, PhenotypePartition::kNumPartitions,
+                                        PhenotypePartition());
+    auto* op = new Operation("neighbor index");
+    op->AddOperationImpl(kCpu, neighbors);
+    sim->GetScheduler()->ScheduleOp(op, OpType::kPreSchedule);
+  }
+
+  // the phenotype-1 cells of example "ex11" neither move nor grow
+  auto generate_grid_of_cells = [](const Real3& xyz) {
+    MyCell* cell = new MyCell();
+    cell->SetDiameter(4.0);
+    cell->SetDensity(10.0);
+    cell->SetPosition(xyz);
+    cell->SetPhenotype(1);
+    return cell;
+  };
+  const size_t agents_per_dim = std::lround(7 * length / 100.0);
+  ModelInitializer::Grid3D(agents_per_dim, (param->max_bound-param->min_bound)/(agents_per_dim-1),
+                           generate_grid_of_cells);
+
+  auto generate_cluster_of_cells = [&](const Real3& xyz) {
+    MyCell* cell = new MyCell();
+    cell->SetDiameter(2.0);
+    cell->SetDensity(1.0);
+    cell->SetPosition(xyz);
+    cell->SetPhenotype(2);
+    const HeterotypicContactInhibition inhibition(1.8 * ((2.0+4.0)/2.0), safe_distance, neighbors);
+    cell->AddBehavior(new CellGrowthDivision<MyCell, HeterotypicContactInhibition>(
+        3.0, 0.025, 1.0, inhibition));
+    return cell;
+  };
+  ModelInitializer::CreateAgentsRandom(param->min_bound, param->max_bound,
+                                       cells, generate_cluster_of_cells);
+}
+
+// the wall time per step of the model above, in milliseconds
+inline real_t RunContactInhibitionScenario(CommandLineOptions* clo, uint64_t cells,
+                                           uint64_t steps, NeighborSearch search) {
+  Simulation sim(clo, [&](Param* param) { SetContactInhibitionParameters(param, cells); });
+  InitializeContactInhibitionModel(&sim, cells, search);
+
+  const auto start = std::chrono::steady_clock::now();
+  sim.GetScheduler()->Simulate(steps);
+  const std::chrono::duration<real_t, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / steps;
+}
+
+/*
+Benchmark of the contact inhibition of example "ex11", searching for an
+adjacent cell of different phenotype through the execution context of the
+simulation engine ('engine'), through a neighbor index that stops at the
+first match ('indexed') and through the same index partitioned by phenotype
+('partitioned'), with up to tens of thousands of phenotype-2 cells. The
+speedups are relative to the engine.
+Prints the best of a few repetitions as CSV, e.g.:
+  ./build/bench_contact_inhibition --steps 20 --repeat 3 --max-cells 30000
+*/
+inline int bench_contact_inhibition(int argc, const char* argv[]) {
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<uint64_t>("steps", "20", "Number of simulated steps per run");
+  clo.AddOption<uint64_t>("repeat", "3", "Number of runs per scenario (the best is reported)");
+  clo.AddOption<uint64_t>("max-cells", "30000", "Largest number of phenotype-2 cells");
+  const uint64_t steps = std::max<uint64_t>(clo.Get<uint64_t>("steps"), 1);
+  const uint64_t repeat = std::max<uint64_t>(clo.Get<uint64_t>("repeat"), 1);
+  const uint64_t max_cells = clo.Get<uint64_t>("max-cells");
+
+  auto best_of = [&](auto run) {
+    real_t best = std::numeric_limits<real_t>::max();
+    for (uint64_t r = 0; r < repeat; ++r) best = std::min(best, run());
+    return best;
+  };
+
+  std::printf("cells,steps,engine_ms_per_step,indexed_ms_per_step,partitioned_ms_per_step,"
+              "indexed_speedup,partitioned_speedup\n");
+  for (uint64_t cells : {1000, 3000, 10000, 30000, 100000}) {
+    if (cells > max_cells) break;
+    auto run = [&](NeighborSearch search) {
+      return best_of([&]() { return RunContactInhibitionScenario(&clo, cells, steps, search); });
+    };
+    const real_t engine = run(NeighborSearch::kEngine);
+    const real_t indexed = run(NeighborSearch::kIndexed);
+    const real_t partitioned = run(NeighborSearch::kPartitioned);
+    std::printf("%llu,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n", static_cast<unsigned long long>(cells),
+                static_cast<unsigned long long>(steps), engine, indexed, partitioned,
+                engine / indexed, engine / partitioned);
+  }
+  return 0;
+}
+
+} // namespace bdm
+
+#endif // BENCH_CONTACT_INHIBITION_H_
@@ -0,0 +1,156 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef BENCH_DIFFUSION_H_
+#define BENCH_DIFFUSION_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+#include "biodynamo.h"
+#include "core/behavior/secretion.h"
+#include "substances.h"
+
+namespace bdm {
+
+enum Substances { kCytokine };
+
+/*
+Solver of the substance of examples "ex8" and "ex9": the finite difference
+stencil of the simulation engine (kEuler), or the pointwise decay of a
+substance that does not diffuse (kDecay, see 'common/src/decay_grid.h').
+*/
+enum class SubstanceSolver { kEuler, kDecay };
+
+/*
+Sets up the substance and the secreting cells of example "ex<example>" (8 or
+9) on a lattice of the given resolution; the cells neither move nor grow, so
+that the concentrations do not depend on the solver but for its accuracy.
+Returns the wall time per step in milliseconds and copies the concentrations
+of the last step into 'field'.
+*/
+inline real_t RunSubstanceScenario(CommandLineOptions* clo, int example, int resolution,
+                                   uint64_t steps, SubstanceSolver solver,
+                                   std::vector<real_t>* field) {
+  auto set_parameters = [](Param* param) {
+    param->use_progress_bar = false;
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound =   0.0;
+    param->max_bound = 100.0;
+    param->export_visualization = false;
+    param->calculate_gradients = false;
+    param->diffusion_method = "euler";
+    param->statistics = false;
+    param->simulation_time_step = 1.0;
+  };
+
+  Simulation sim(clo, set_parameters);
+  const Param* param = sim.GetParam();
+  const real_t domain_center = 0.5*(param->max_bound+param->min_bound);
+  const real_t domain_delta = 0.5*(param->max_bound-param->min_bound);
+
+  if (solver == SubstanceSolver::kEuler) {
+    ModelInitializer::DefineSubstance(kCytokine, "TGF", 0.0, 0.05e-3, resolution);
+  } else {
+    DefineSubstance(kCytokine, "TGF", 0.0, 0.05e-3, resolution);
+  }
+  ModelInitializer::AddBoundaryConditions(kCytokine, BoundaryConditionType::kNeumann,
+                                          std::make_unique<ConstantBoundaryCondition>(0));
+
+  auto new_cell = [](const Real3& xyz, real_t diameter, real_t secretion_rate) {
+    Cell* cell = new Cell();
+    cell->SetDiameter(diameter);
+    cell->SetPosition(xyz);
+    cell->AddBehavior(new Secretion("TGF", secretion_rate));
+    return cell;
+  };
+  if (example == 9) {
+    // the phenotype-1 cells of example "ex9" only uptake "TGF"
+    ModelInitializer::CreateAgentsRandom(domain_center-0.9*domain_delta,domain_center+0.9*domain_delta, 777,
+                                         [&](const Real3& xyz) { return new_cell(xyz, 4.0, -0.2e-3); });
+  }
+  const real_t radius = (example == 9 ? 0.85 : 0.90)*domain_delta;
+  ModelInitializer::CreateAgentsInSphereRndm({domain_center, domain_center, domain_center}, radius, 2222,
+                                             [&](const Real3& xyz) { return new_cell(xyz, 2.0, 0.2e-3); });
+
+  const auto start = std::chrono::steady_clock::now();
+  sim.GetScheduler()->Simulate(steps);
+  const std::chrono::duration<real_t, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  const auto* grid = sim.GetResourceManager()->GetDiffusionGrid(kCytokine);
+  field->assign(grid->GetAllConcentrations(), grid->GetAllConcentrations() + grid->GetNumBoxes());
+  return elapsed.count() / steps;
+}
+
+// largest difference of two fields, relative to the largest magnitude
+inline real_t MaxRelativeDifference(const std::vector<real_t>& a, const std::vector<real_t>& b) {
+  real_t diff = 0.0, norm = std::numeric_limits<real_t>::min();
+  for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+    diff = std::max(diff, std::abs(a[i] - b[i]));
+    norm = std::max(norm, std::abs(a[i]));
+  }
+  return diff / norm;
+}
+
+/*
+Benchmark of the substance of examples "ex8" and "ex9", which does not
+diffuse, solved by the finite difference stencil of the simulation engine
+('euler') and by the pointwise exponential decay ('decay') at increasing
+lattice resolutions (starting with the 51^3 voxels of the examples). The
+speedup is relative to the engine, and the deviation is the largest
+difference of the final concentrations relative to the largest one.
+Prints the best of a few repetitions as CSV, e.g.:
+  ./build/bench_diffusion --steps 100 --repeat 3 --max-resolution 151
+*/
+inline int bench_diffusion(int argc, const char* argv[]) {
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<uint64_t>("steps", "100", "Number of simulated steps per run");
+  clo.AddOption<uint64_t>("repeat", "3", "Number of runs per scenario (the best is reported)");
+  clo.AddOption<int>("max-resolution", "151", "Largest number of voxels per dimension");
+  const uint64_t steps = std::max<uint64_t>(clo.Get<uint64_t>("steps"), 1);
+  const uint64_t repeat = std::max<uint64_t>(clo.Get<uint64_t>("repeat"), 1);
+  const int max_resolution = clo.Get<int>("max-resolution");
+
+  std::printf("example,resolution,steps,euler_ms_per_step,decay_ms_per_step,"
+              "decay_speedup,decay_deviation\n");
+  for (int example : {8, 9}) {
+    for (int resolution : {51, 101, 151, 201}) {
+      if (resolution > max_resolution) break;
+      std::vector<real_t> euler_field, decay_field;
+      auto run = [&](SubstanceSolver solver, std::vector<real_t>* field) {
+        real_t best = std::numeric_limits<real_t>::max();
+        for (uint64_t r = 0; r < repeat; ++r) {
+          best = std::min(best, RunSubstanceScenario(&clo, example, resolution, steps,
+                                                     solver, field));
+        }
+        return best;
+      };
+      const real_t euler = run(SubstanceSolver::kEuler, &euler_field);
+      const real_t decay = run(SubstanceSolver::kDecay, &decay_field);
+      std::printf("ex%02d,%d,%llu,%.3f,%.3f,%.3f,%.3e\n", example, resolution,
+                  static_cast<unsigned long long>(steps), euler, decay, euler / decay,
+                  MaxRelativeDifference(euler_field, decay_field));
+    }
+  }
+  return 0;
+}
+
+} // namespace bdm
+
+#endif // BENCH_DIFFUSION_H_
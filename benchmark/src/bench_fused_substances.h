@@ -0,0 +1,129 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef BENCH_FUSED_SUBSTANCES_H_
+#define BENCH_FUSED_SUBSTANCES_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+#include "bench_diffusion.h"
+#include "fused_substance_grid.h"
+#include "substances.h"
+#include "tiled_euler_grid.h"
+
+namespace bdm {
+
+/*
+Microbenchmark of the time step of 1 to 4 diffusing substances (each with
+its own diffusion coefficient and decay constant) of the same lattice: a
+sweep per substance by the tiled kernel of 'common/src/tiled_euler_grid.h'
+('separate') and a single sweep over their interleaved concentrations by
+'common/src/fused_substance_grid.h' ('fused'), for a lattice of 91^3 voxels
+(example "ex10") by default. Reports the wall time of a time step of all
+substances and the largest difference of the final concentrations relative
+to the largest one, as the best of a few repetitions in CSV, e.g.:
+  ./build/bench_fused_substances --steps 20 --repeat 3 --resolution 91
+*/
+inline int bench_fused_substances(int argc, const char* argv[]) {
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<uint64_t>("steps", "20", "Number of time steps per run");
+  clo.AddOption<uint64_t>("repeat", "3", "Number of runs per number of substances (the best is reported)");
+  clo.AddOption<int>("resolution", "91", "Number of voxels per dimension");
+  const uint64_t steps = std::max<uint64_t>(clo.Get<uint64_t>("steps"), 1);
+  const uint64_t repeat = std::max<uint64_t>(clo.Get<uint64_t>("repeat"), 1);
+  const int resolution = std::max(clo.Get<int>("resolution"), 2);
+
+  std::printf("resolution,substances,steps,separate_ms_per_step,fused_ms_per_step,"
+              "fused_speedup,fused_deviation\n");
+  for (int k = 1; k <= 4; ++k) {
+    auto set_parameters = [](Param* param) {
+      param->use_progress_bar = false;
+      param->min_bound =   0.0;
+      param->max_bound = 100.0;
+      param->export_visualization = false;
+      param->calculate_gradients = false;
+      param->diffusion_method = "euler";
+      param->statistics = false;
+      param->simulation_time_step = 1.0;
+    };
+    Simulation sim(&clo, set_parameters);
+    auto* rm = sim.GetResourceManager();
+
+    // up to about a tenth of a voxel per step, well below the stability
+    // limit, and a different rate for every substance
+    const real_t box_length = 100.0 / resolution;
+    for (int s = 0; s < k; ++s) {
+      const real_t diffusion_rate = 0.1 / (s + 1) * box_length * box_length;
+      const real_t decay_rate = 0.01 * s;
+      rm->AddContinuum(new TiledEulerGrid(s, "separate" + std::to_string(s), diffusion_rate,
+                                          decay_rate, resolution));
+      rm->AddContinuum(new FusedSubstanceGrid(k + s, "fused" + std::to_string(s),
+                                              diffusion_rate, decay_rate, resolution));
+    }
+    for (int id = 0; id < 2 * k; ++id) {
+      const real_t phase = id % k;
+      ModelInitializer::AddBoundaryConditions(id, BoundaryConditionType::kNeumann,
+                                              std::make_unique<ConstantBoundaryCondition>(0));
+      // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
+      ModelInitializer::InitializeSubstance(id, [phase](real_t x, real_t y, real_t z) {
+        return 1.0 + std::sin(0.1 * x + phase) * std::cos(0.2 * y) * std::sin(0.3 * z);
+      });
+    }
+    // sets up the lattices (and takes their first time step)
+    sim.GetScheduler()->Simulate(1);
+
+    auto run = [&](int first) {
+      real_t best = std::numeric_limits<real_t>::max();
+      for (uint64_t r = 0; r < repeat; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t step = 0; step < steps; ++step) {
+          for (int s = 0; s < k; ++s) rm->GetDiffusionGrid(first + s)->Diffuse(1.0);
+        }
+        const std::chrono::duration<real_t, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / steps);
+      }
+      return best;
+    };
+    const real_t separate = run(0);
+    const real_t fused = run(k);
+
+    real_t deviation = 0.0;
+    for (int s = 0; s < k; ++s) {
+      auto* a = rm->GetDiffusionGrid(s);
+      auto* b = rm->GetDiffusionGrid(k + s);
+      SynchronizeConcentration(b);
+      const real_t* ca = a->GetAllConcentrations();
+      const real_t* cb = b->GetAllConcentrations();
+      deviation = std::max(deviation, MaxRelativeDifference(
+          std::vector<real_t>(ca, ca + a->GetNumBoxes()),
+          std::vector<real_t>(cb, cb + b->GetNumBoxes())));
+    }
+    std::printf("%d,%d,%llu,%.3f,%.3f,%.3f,%.3e\n", resolution, k,
+                static_cast<unsigned long long>(steps), separate, fused, separate / fused,
+                deviation);
+  }
+  return 0;
+}
+
+} // namespace bdm
+
+#endif // BENCH_FUSED_SUBSTANCES_H_
@@ -0,0 +1,103 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef BENCH_RANDOM_H_
+#define BENCH_RANDOM_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+#include "biodynamo.h"
+#include "counter_random.h"
+
+namespace bdm {
+
+/*
+Microbenchmark of the uniform random numbers drawn by the migration of a
+population of agents, 4 per agent and time step as by the migration
+behavior of the examples before it slept between moves (one number to
+decide and three for the displacement): through the 'Random' facade of the
+simulation engine ('facade'), by a 'CounterRandom' per agent ('counter')
+and in bulk by 'CounterUniforms' ('bulk', see 'common/src/counter_random.h'),
+all with the threads of the engine. Reports the random numbers drawn per
+nanosecond, and whether the bulk numbers are bit for bit those of the
+'CounterRandom', as the best of a few repetitions in CSV, e.g.:
+  ./build/bench_random --repeat 5 --max-agents 1000000
+*/
+inline int bench_random(int argc, const char* argv[]) {
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<uint64_t>("repeat", "5", "Number of runs per population (the best is reported)");
+  clo.AddOption<uint64_t>("max-agents", "1000000", "Largest number of agents");
+  const uint64_t repeat = std::max<uint64_t>(clo.Get<uint64_t>("repeat"), 1);
+  const uint64_t max_agents = clo.Get<uint64_t>("max-agents");
+
+  auto set_parameters = [](Param* param) {
+    param->use_progress_bar = false;
+    param->export_visualization = false;
+    param->statistics = false;
+  };
+  Simulation sim(&clo, set_parameters);
+  const uint64_t seed = sim.GetParam()->random_seed;
+  constexpr size_t kDraws = 4;
+  const uint64_t step = 42;
+
+  std::printf("agents,draws_per_agent,facade_draws_per_ns,counter_draws_per_ns,"
+              "bulk_draws_per_ns,bulk_speedup,bulk_identical\n");
+  for (size_t n : {10000, 100000, 1000000}) {
+    if (n > max_agents) break;
+    std::vector<AgentUid> uids(n);
+    for (size_t i = 0; i < n; ++i) uids[i] = AgentUid(static_cast<uint32_t>(i), 0);
+    std::vector<real_t> counter(kDraws * n), bulk(kDraws * n);
+
+    auto run = [&](auto&& draw) {
+      real_t best = std::numeric_limits<real_t>::max();
+      for (uint64_t r = 0; r < repeat; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        draw();
+        const std::chrono::duration<real_t, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+      }
+      return kDraws * n / best;
+    };
+    const real_t facade = run([&]() {
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < n; ++i) {
+        // https://biodynamo.github.io/api/classbdm_1_1Random.html
+        auto* random = sim.GetRandom();
+        for (size_t j = 0; j < kDraws; ++j) counter[i * kDraws + j] = random->Uniform();
+      }
+    });
+    const real_t scalar = run([&]() {
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < n; ++i) {
+        CounterRandom rand(seed, uids[i], step, kMigrationStream);
+        for (size_t j = 0; j < kDraws; ++j) counter[i * kDraws + j] = rand.Uniform();
+      }
+    });
+    const real_t batch = run([&]() {
+      CounterUniforms(seed, uids.data(), n, step, kMigrationStream, kDraws, bulk.data());
+    });
+    std::printf("%zu,%zu,%.4f,%.4f,%.4f,%.3f,%d\n", n, kDraws, facade, scalar, batch,
+                batch / facade, static_cast<int>(counter == bulk));
+  }
+  return 0;
+}
+
+} // namespace bdm
+
+#endif // BENCH_RANDOM_H_
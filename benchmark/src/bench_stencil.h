@@ -0,0 +1,239 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef BENCH_STENCIL_H_
+#define BENCH_STENCIL_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "biodynamo.h"
+#include "bench_diffusion.h"
+#include "mixed_precision_grid.h"
+#include "substances.h"
+#include "tiled_euler_grid.h"
+
+namespace bdm {
+
+/*
+Reference check of the lattices of the "euler" method (see the 'substances.h'
+header file) against the engine's: a lattice of 37^3 voxels (two tiles
+along z, a partial tile along y) of every kind of boundary condition takes
+the given time steps as the engine's lattice ('engine'), as a
+'TiledEulerGrid' ('tiled') and as a 'MixedPrecisionGrid' ('mixed'). Prints
+the deviation of every one (the largest difference of the concentrations
+relative to the largest one) to stderr and returns the largest deviation of
+the tiled and of the mixed lattices.
+*/
+inline std::pair<real_t, real_t> CheckStencil(CommandLineOptions* clo, uint64_t steps) {
+  auto set_parameters = [](Param* param) {
+    param->use_progress_bar = false;
+    param->min_bound =   0.0;
+    param->max_bound = 100.0;
+    param->export_visualization = false;
+    param->calculate_gradients = false;
+    param->diffusion_method = "euler";
+    param->statistics = false;
+    param->simulation_time_step = 1.0;
+  };
+  Simulation sim(clo, set_parameters);
+  auto* rm = sim.GetResourceManager();
+
+  const int resolution = 37;
+  const real_t box_length = 100.0 / resolution;
+  const real_t diffusion_rate = 0.1 * box_length * box_length;
+  const real_t decay_rate = 0.01;
+  const std::vector<std::pair<BoundaryConditionType, const char*>> boundaries = {
+      {BoundaryConditionType::kNeumann, "neumann"},
+      {BoundaryConditionType::kClosedBoundaries, "closed"},
+      {BoundaryConditionType::kOpenBoundaries, "open"},
+      {BoundaryConditionType::kPeriodic, "periodic"},
+      {BoundaryConditionType::kDirichlet, "dirichlet"}};
+  auto initial = [](real_t x, real_t y, real_t z) {
+    return 1.0 + std::sin(0.1 * x) * std::cos(0.2 * y) * std::sin(0.3 * z);
+  };
+  // the engine's, the tiled and the mixed lattice of boundary b are 3b to 3b+2
+  for (size_t b = 0; b < boundaries.size(); ++b) {
+    const int id = 3 * b;
+    const std::string name = boundaries[b].second;
+    ModelInitializer::DefineSubstance(id, "engine_" + name, diffusion_rate, decay_rate,
+                                      resolution);
+    rm->AddContinuum(new TiledEulerGrid(id + 1, "tiled_" + name, diffusion_rate, decay_rate,
+                                        resolution));
+    rm->AddContinuum(new MixedPrecisionGrid(id + 2, "mixed_" + name, diffusion_rate,
+                                            decay_rate, resolution));
+    // a nonzero value for the Dirichlet boundaries, zero flux otherwise
+    const bool dirichlet = boundaries[b].first == BoundaryConditionType::kDirichlet;
+    for (int i = id; i < id + 3; ++i) {
+      ModelInitializer::AddBoundaryConditions(
+          i, boundaries[b].first, std::make_unique<ConstantBoundaryCondition>(dirichlet ? 0.5 : 0));
+      ModelInitializer::InitializeSubstance(i, initial);
+    }
+  }
+  // sets up the lattices (and takes their first time step)
+  sim.GetScheduler()->Simulate(1);
+  for (uint64_t s = 0; s < steps; ++s) {
+    for (size_t i = 0; i < 3 * boundaries.size(); ++i) rm->GetDiffusionGrid(i)->Diffuse(1.0);
+  }
+
+  std::pair<real_t, real_t> worst = {0.0, 0.0};
+  for (size_t b = 0; b < boundaries.size(); ++b) {
+    auto* engine_grid = rm->GetDiffusionGrid(3 * b);
+    auto deviation = [&](DiffusionGrid* grid) {
+      SynchronizeConcentration(grid);
+      const real_t* a = engine_grid->GetAllConcentrations();
+      const real_t* c = grid->GetAllConcentrations();
+      return MaxRelativeDifference(std::vector<real_t>(a, a + engine_grid->GetNumBoxes()),
+                                   std::vector<real_t>(c, c + grid->GetNumBoxes()));
+    };
+    const real_t tiled = deviation(rm->GetDiffusionGrid(3 * b + 1));
+    const real_t mixed = deviation(rm->GetDiffusionGrid(3 * b + 2));
+    std::fprintf(stderr, "check %s: tiled_deviation %.3e, mixed_deviation %.3e\n",
+                 boundaries[b].second, tiled, mixed);
+    worst = {std::max(worst.first, tiled), std::max(worst.second, mixed)};
+  }
+  return worst;
+}
+
+/*
+Microbenchmark of the explicit finite difference kernel of a diffusing
+substance: the "euler" lattice of the simulation engine ('engine') and the
+tiled, vectorized kernel of 'common/src/tiled_euler_grid.h' ('tiled'), also
+over a lattice stored in float ('mixed', see
+'common/src/mixed_precision_grid.h'), for lattices of 51^3, 91^3 (example
+"ex10") and 256^3 voxels. All lattices start from the same concentrations
+and take the same time steps; besides the wall
+time per step it reports the effective memory bandwidth (every voxel read
+and written once per step) and the voxel updates per second, as well as the
+largest difference of the final concentrations relative to the largest one.
+Prints the best of a few repetitions as CSV, e.g.:
+  ./build/bench_stencil --steps 20 --repeat 3 --max-resolution 256
+First runs 'CheckStencil', and fails (returns 1) if a deviation, of the
+check or of the benchmark, exceeds the tolerance of its lattice; the check
+alone is run by '--max-resolution 0' (see the 'run_suite.sh' script).
+*/
+inline int bench_stencil(int argc, const char* argv[]) {
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<uint64_t>("steps", "20", "Number of time steps per run");
+  clo.AddOption<uint64_t>("repeat", "3", "Number of runs per lattice (the best is reported)");
+  clo.AddOption<int>("max-resolution", "256", "Largest number of voxels per dimension");
+  clo.AddOption<real_t>("tolerance", "1e-10", "Largest deviation of the tiled lattice from the engine's");
+  clo.AddOption<real_t>("mixed-tolerance", "1e-5", "Largest deviation of the mixed lattice from the engine's");
+  const uint64_t steps = std::max<uint64_t>(clo.Get<uint64_t>("steps"), 1);
+  const uint64_t repeat = std::max<uint64_t>(clo.Get<uint64_t>("repeat"), 1);
+  const int max_resolution = clo.Get<int>("max-resolution");
+  const real_t tolerance = clo.Get<real_t>("tolerance");
+  const real_t mixed_tolerance = clo.Get<real_t>("mixed-tolerance");
+
+  int failed = 0;
+  auto check = [&](const char* what, real_t deviation, real_t limit) {
+    if (deviation <= limit) return;
+    std::fprintf(stderr, "FAILED: %s deviates by %.3e from the engine (tolerance %.1e)\n",
+                 what, deviation, limit);
+    failed = 1;
+  };
+  const auto reference = CheckStencil(&clo, steps);
+  check("tiled lattice", reference.first, tolerance);
+  check("mixed lattice", reference.second, mixed_tolerance);
+
+  std::printf("resolution,steps,engine_ms_per_step,tiled_ms_per_step,engine_gb_per_s,"
+              "tiled_gb_per_s,engine_voxels_per_s,tiled_voxels_per_s,tiled_speedup,"
+              "tiled_deviation,mixed_ms_per_step,mixed_gb_per_s,mixed_speedup,"
+              "mixed_deviation\n");
+  for (int resolution : {51, 91, 256}) {
+    if (resolution > max_resolution) break;
+    auto set_parameters = [](Param* param) {
+      param->use_progress_bar = false;
+      param->min_bound =   0.0;
+      param->max_bound = 100.0;
+      param->export_visualization = false;
+      param->calculate_gradients = false;
+      param->diffusion_method = "euler";
+      param->statistics = false;
+      param->simulation_time_step = 1.0;
+    };
+    Simulation sim(&clo, set_parameters);
+    auto* rm = sim.GetResourceManager();
+
+    // about a tenth of a voxel per step, well below the stability limit
+    const real_t box_length = 100.0 / resolution;
+    const real_t diffusion_rate = 0.1 * box_length * box_length;
+    const real_t decay_rate = 0.01;
+    ModelInitializer::DefineSubstance(0, "engine", diffusion_rate, decay_rate, resolution);
+    rm->AddContinuum(new TiledEulerGrid(1, "tiled", diffusion_rate, decay_rate, resolution));
+    rm->AddContinuum(new MixedPrecisionGrid(2, "mixed", diffusion_rate, decay_rate, resolution));
+    auto initial = [](real_t x, real_t y, real_t z) {
+      return 1.0 + std::sin(0.1 * x) * std::cos(0.2 * y) * std::sin(0.3 * z);
+    };
+    for (int id : {0, 1, 2}) {
+      ModelInitializer::AddBoundaryConditions(id, BoundaryConditionType::kNeumann,
+                                              std::make_unique<ConstantBoundaryCondition>(0));
+      // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
+      ModelInitializer::InitializeSubstance(id, initial);
+    }
+    // sets up the lattices (and takes their first time step)
+    sim.GetScheduler()->Simulate(1);
+
+    auto run = [&](DiffusionGrid* grid) {
+      real_t best = std::numeric_limits<real_t>::max();
+      for (uint64_t r = 0; r < repeat; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t s = 0; s < steps; ++s) grid->Diffuse(1.0);
+        const std::chrono::duration<real_t, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / steps);
+      }
+      return best;
+    };
+    auto* engine_grid = rm->GetDiffusionGrid(0);
+    auto* tiled_grid = rm->GetDiffusionGrid(1);
+    auto* mixed_grid = rm->GetDiffusionGrid(2);
+    const real_t engine = run(engine_grid);
+    const real_t tiled = run(tiled_grid);
+    const real_t mixed = run(mixed_grid);
+    SynchronizeConcentration(mixed_grid);
+
+    const real_t voxels = engine_grid->GetNumBoxes();
+    auto gb_per_s = [&](real_t ms, size_t bytes) { return 2.0 * bytes * voxels / (ms * 1e6); };
+    auto voxels_per_s = [&](real_t ms) { return voxels / (ms * 1e-3); };
+    auto deviation = [&](DiffusionGrid* grid) {
+      const real_t* a = engine_grid->GetAllConcentrations();
+      const real_t* b = grid->GetAllConcentrations();
+      return MaxRelativeDifference(std::vector<real_t>(a, a + engine_grid->GetNumBoxes()),
+                                   std::vector<real_t>(b, b + grid->GetNumBoxes()));
+    };
+    const real_t tiled_deviation = deviation(tiled_grid);
+    const real_t mixed_deviation = deviation(mixed_grid);
+    std::printf("%d,%llu,%.3f,%.3f,%.2f,%.2f,%.3e,%.3e,%.3f,%.3e,%.3f,%.2f,%.3f,%.3e\n",
+                resolution, static_cast<unsigned long long>(steps), engine, tiled,
+                gb_per_s(engine, sizeof(real_t)), gb_per_s(tiled, sizeof(real_t)),
+                voxels_per_s(engine), voxels_per_s(tiled), engine / tiled,
+                tiled_deviation, mixed, gb_per_s(mixed, sizeof(float)),
+                engine / mixed, mixed_deviation);
+    check("tiled lattice", tiled_deviation, tolerance);
+    check("mixed lattice", mixed_deviation, mixed_tolerance);
+  }
+  return failed;
+}
+
+} // namespace bdm
+
+#endif // BENCH_STENCIL_H_
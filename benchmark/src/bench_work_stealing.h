@@ -0,0 +1,294 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef BENCH_WORK_STEALING_H_
+#define BENCH_WORK_STEALING_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "biodynamo.h"
+#include "bench_contact_inhibition.h"
+#include "cell_growth_division.h"
+#include "work_stealing.h"
+
+namespace bdm {
+
+/*
+The wall time of every time step (in milliseconds), from the first of the
+operations scheduled before it (with 'Install') to the last scheduled after.
+*/
+class StepTimes {
+  public:
+    void Install(Scheduler* scheduler) {
+      // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+      auto* start = new Operation("step start");
+      start->AddOperationImpl(kCpu, new StepClock(this, true));
+      scheduler->ScheduleOp(start, OpType::kPreSchedule);
+      auto* end = new Operation("step end");
+      end->AddOperationImpl(kCpu, new StepClock(this, false));
+      scheduler->ScheduleOp(end, OpType::kPostSchedule);
+    }
+
+    const std::vector<real_t>& Get() const { return ms_; }
+
+    // the given quantile (between 0 and 1) of the times of the steps
+    real_t Quantile(real_t q) const {
+      if (ms_.empty()) return 0.0;
+      std::vector<real_t> sorted = ms_;
+      std::sort(sorted.begin(), sorted.end());
+      const size_t i = static_cast<size_t>(std::ceil(q * sorted.size()));
+      return sorted[std::clamp<size_t>(i, 1, sorted.size()) - 1];
+    }
+
+  private:
+    class StepClock : public StandaloneOperationImpl {
+      BDM_OP_HEADER(StepClock);
+
+      public:
+        StepClock() = default;
+        StepClock(StepTimes* times, bool start) : times_(times), start_(start) {}
+
+        void operator()() override {
+          const auto now = std::chrono::steady_clock::now();
+          if (start_) {
+            times_->start_ = now;
+          } else {
+            const std::chrono::duration<real_t, std::milli> elapsed = now - times_->start_;
+            times_->ms_.push_back(elapsed.count());
+          }
+        }
+
+      private:
+        StepTimes* times_ = nullptr;
+        bool start_ = true;
+    };
+
+    std::chrono::steady_clock::time_point start_;
+    std::vector<real_t> ms_;
+};
+
+/*
+The wall time of every time step (in milliseconds) from the last operation
+scheduled before it (with 'Install', i.e., after the work stealing) to the
+first standalone operation, i.e., the loop of the engine over the agents,
+which only calls the wrapped agent operations that do nothing when they are
+run by the work stealing.
+*/
+class EnginePass {
+  public:
+    void Install(Scheduler* scheduler) {
+      for (const auto& name : scheduler->GetListOfScheduledStandaloneOps()) {
+        for (auto* op : scheduler->GetOps(name)) {
+          // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+          auto*& impl = op->implementations_[kCpu];
+          impl = new MarkedStandaloneOp(this, static_cast<StandaloneOperationImpl*>(impl));
+        }
+      }
+      auto* start = new Operation("engine pass start");
+      start->AddOperationImpl(kCpu, new MarkedStandaloneOp(this, nullptr));
+      scheduler->ScheduleOp(start, OpType::kPreSchedule);
+    }
+
+    real_t Median() const {
+      if (ms_.empty()) return 0.0;
+      std::vector<real_t> sorted = ms_;
+      std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+      return sorted[sorted.size() / 2];
+    }
+
+  private:
+    // starts the pass if it wraps no operation, ends it (once) otherwise
+    class MarkedStandaloneOp : public StandaloneOperationImpl {
+      BDM_OP_HEADER(MarkedStandaloneOp);
+
+      public:
+        MarkedStandaloneOp() = default;
+        MarkedStandaloneOp(EnginePass* pass, StandaloneOperationImpl* impl)
+          : pass_(pass), impl_(impl) {}
+
+        void SetUp() override {
+          if (impl_) impl_->SetUp();
+        }
+        void TearDown() override {
+          if (impl_) impl_->TearDown();
+        }
+        void operator()() override {
+          const auto now = std::chrono::steady_clock::now();
+          if (impl_ == nullptr) {
+            pass_->start_ = now;
+            pass_->armed_ = true;
+            return;
+          }
+          if (pass_->armed_) {
+            const std::chrono::duration<real_t, std::milli> elapsed = now - pass_->start_;
+            pass_->ms_.push_back(elapsed.count());
+            pass_->armed_ = false;
+          }
+          (*impl_)();
+        }
+
+      private:
+        EnginePass* pass_ = nullptr;
+        std::shared_ptr<StandaloneOperationImpl> impl_;
+    };
+
+    bool armed_ = false;
+    std::chrono::steady_clock::time_point start_;
+    std::vector<real_t> ms_;
+};
+
+// the tail of the times of the steps of a run, and the agents at its end
+struct StepLatency {
+  real_t p50 = 0.0, p99 = 0.0, max = 0.0;
+  real_t imbalance = 0.0, steals_per_step = 0.0;
+  // median time of the loop of the engine over the agents
+  real_t engine_pass = 0.0;
+  uint64_t agents = 0;
+};
+
+enum class WorkStealingModel { kEx04, kEx11 };
+
+/*
+Runs the model of example "ex04" (a single cell growing and dividing into a
+colony) or of example "ex11" (with the given number of phenotype-2 cells,
+see 'bench_contact_inhibition.h') for the given number of steps, with the
+agent operations run by the simulation engine or by work stealing (see
+'common/src/work_stealing.h').
+*/
+inline StepLatency RunWorkStealingScenario(CommandLineOptions* clo, WorkStealingModel model,
+                                           uint64_t cells, uint64_t steps, bool stealing,
+                                           uint32_t chunk_size) {
+  auto set_parameters = [&](Param* param) {
+    if (model == WorkStealingModel::kEx11) {
+      SetContactInhibitionParameters(param, cells);
+      return;
+    }
+    param->use_progress_bar = false;
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = 0.0;
+    param->max_bound = 100.0;
+    param->export_visualization = false;
+    param->statistics = false;
+    param->simulation_time_step = 1.0;
+  };
+  Simulation sim(clo, set_parameters);
+  auto* scheduler = sim.GetScheduler();
+
+  if (model == WorkStealingModel::kEx11) {
+    InitializeContactInhibitionModel(&sim, cells, NeighborSearch::kEngine);
+  } else {
+    // the model parameters of example "ex04"
+    const real_t center = 50.0;
+    Cell* cell = new Cell({center, center, center});
+    cell->SetDiameter(2.0);
+    cell->SetDensity(1.0);
+    cell->AddBehavior(new CellGrowthDivision<Cell>(3.0, 0.12, 0.9));
+    sim.GetResourceManager()->AddAgent(cell);
+  }
+
+  StepTimes times;
+  times.Install(scheduler);
+  WorkStealing* work_stealing = nullptr;
+  if (stealing) {
+    work_stealing = new WorkStealing(chunk_size);
+    work_stealing->Install(scheduler);
+  }
+  EnginePass engine_pass;
+  engine_pass.Install(scheduler);
+  scheduler->Simulate(steps);
+
+  StepLatency latency;
+  latency.p50 = times.Quantile(0.5);
+  latency.p99 = times.Quantile(0.99);
+  latency.max = times.Quantile(1.0);
+  latency.engine_pass = engine_pass.Median();
+  latency.agents = sim.GetResourceManager()->GetNumAgents();
+  if (work_stealing != nullptr) {
+    const auto& imbalance = work_stealing->GetImbalance();
+    for (real_t i : imbalance) latency.imbalance += i;
+    latency.imbalance /= std::max<size_t>(imbalance.size(), 1);
+    latency.steals_per_step = static_cast<real_t>(work_stealing->GetNumSteals()) / steps;
+  }
+  return latency;
+}
+
+/*
+Benchmark of the execution of the agent operations by work stealing on the
+spatially clustered divisions of examples "ex04" (at the rim of a colony
+growing from a single cell) and "ex11" (of the phenotype-2 cells free of
+contact inhibition): the median, 99th percentile and largest wall time per
+step with the agent operations run by the simulation engine ('engine') and
+by work stealing ('stealing'), the reduction of the 99th percentile, the
+mean load imbalance of the threads under work stealing (the busiest thread
+over the mean) and the chunks stolen per step. The median time of the loop
+of the engine over the agents (see 'EnginePass') is reported for both: the
+agent operations themselves ('engine_agent_ops_ms'), and the second pass
+over the agents that the engine still makes under work stealing
+('engine_pass_ms'), which is included in the times per step of the latter.
+Every time is the best of a few repetitions; prints CSV, e.g.:
+  ./build/bench_work_stealing --steps 600 --repeat 3 --cells 10000
+*/
+inline int bench_work_stealing(int argc, const char* argv[]) {
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<uint64_t>("steps", "600", "Number of simulated steps per run");
+  clo.AddOption<uint64_t>("repeat", "3", "Number of runs per model and mode (the best is reported)");
+  clo.AddOption<uint64_t>("cells", "10000", "Number of phenotype-2 cells of the model of ex11");
+  clo.AddOption<uint64_t>("chunk", "256", "Number of agents per chunk of the work stealing");
+  const uint64_t steps = std::max<uint64_t>(clo.Get<uint64_t>("steps"), 1);
+  const uint64_t repeat = std::max<uint64_t>(clo.Get<uint64_t>("repeat"), 1);
+  const uint64_t cells = clo.Get<uint64_t>("cells");
+  const uint32_t chunk = static_cast<uint32_t>(std::max<uint64_t>(clo.Get<uint64_t>("chunk"), 1));
+
+  auto best_of = [&](WorkStealingModel model, bool stealing) {
+    StepLatency best;
+    best.p50 = best.p99 = best.max = best.engine_pass = std::numeric_limits<real_t>::max();
+    for (uint64_t r = 0; r < repeat; ++r) {
+      const StepLatency run = RunWorkStealingScenario(&clo, model, cells, steps, stealing, chunk);
+      best.p50 = std::min(best.p50, run.p50);
+      best.p99 = std::min(best.p99, run.p99);
+      best.max = std::min(best.max, run.max);
+      best.engine_pass = std::min(best.engine_pass, run.engine_pass);
+      best.imbalance = run.imbalance;
+      best.steals_per_step = run.steals_per_step;
+      best.agents = run.agents;
+    }
+    return best;
+  };
+
+  std::printf("model,steps,final_agents,engine_p50_ms,engine_p99_ms,engine_max_ms,"
+              "engine_agent_ops_ms,stealing_p50_ms,stealing_p99_ms,stealing_max_ms,"
+              "engine_pass_ms,p99_reduction,stealing_imbalance,steals_per_step\n");
+  for (auto model : {WorkStealingModel::kEx04, WorkStealingModel::kEx11}) {
+    const StepLatency engine = best_of(model, false);
+    const StepLatency stealing = best_of(model, true);
+    std::printf("%s,%llu,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f\n",
+                model == WorkStealingModel::kEx04 ? "ex04" : "ex11",
+                static_cast<unsigned long long>(steps),
+                static_cast<unsigned long long>(stealing.agents), engine.p50, engine.p99,
+                engine.max, engine.engine_pass, stealing.p50, stealing.p99, stealing.max,
+                stealing.engine_pass, 1.0 - stealing.p99 / engine.p99, stealing.imbalance,
+                stealing.steals_per_step);
+  }
+  return 0;
+}
+
+} // namespace bdm
+
+#endif // BENCH_WORK_STEALING_H_
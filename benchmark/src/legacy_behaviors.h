@@ -11,36 +11,89 @@
 // regarding copyright ownership.
 //
 // -----------------------------------------------------------------------------
-#ifndef MY_MIGRATION_H_
-#define MY_MIGRATION_H_
+#ifndef LEGACY_BEHAVIORS_H_
+#define LEGACY_BEHAVIORS_H_
 
-#include "core/behavior/behavior.h"
-#include "core/behavior/secretion.h"
+#include "biodynamo.h"
 
 namespace bdm {
 
-class MyMigration : public Behavior {
-  BDM_BEHAVIOR_HEADER(MyMigration, Behavior, 1);
+/*
+The migration and growth behaviors of examples "ex6" to "ex9" as they were
+written before the (statically dispatched) behaviors in '../common/src'
+replaced them: every call to 'Run' goes through a 'dynamic_cast', branches
+on the behavior flags and looks up the simulation engine. They are kept here
+as the reference point of the benchmarks.
+*/
+class LegacyGrowth : public Behavior {
+  BDM_BEHAVIOR_HEADER(LegacyGrowth, Behavior, 1);
 
   public:
-    MyMigration() { AlwaysCopyToNew(); }
-    MyMigration(real_t migration_rate, real_t propability, bool stick2boundary)
-      : migration_rate_(migration_rate), propability_(propability), stick_to_boundary_(stick2boundary) {}
+    LegacyGrowth() { AlwaysCopyToNew(); }
+    LegacyGrowth(real_t threshold, real_t growth_rate)
+      : threshold_(threshold), growth_rate_(growth_rate) {}
 
-    virtual ~MyMigration() = default;
+    virtual ~LegacyGrowth() = default;
 
     void Initialize(const NewAgentEvent& event) override {
       // https://biodynamo.github.io/api/structbdm_1_1NewAgentEvent.html
       Base::Initialize(event);
 
       // if cell divides then behavior attributes have to be initialized
-      if (auto* b = dynamic_cast<MyMigration*>(event.existing_behavior)) {
+      if (auto* b = dynamic_cast<LegacyGrowth*>(event.existing_behavior)) {
+        threshold_ = b->GetThreshold();
+        growth_rate_ = b->GetGrowthRate();
+      } else {
+        Log::Fatal("LegacyGrowth::Initialize",
+                   "event.existing_behavior was not of type LegacyGrowth");
+      }
+    }
+
+    void Run(Agent* agent) override {
+      if (auto* cell = dynamic_cast<Cell*>(agent)) {
+        // check if cell diameter is below a fixed threshold value
+        if (cell->GetDiameter() <= this->GetThreshold()) {
+          // now increase the cell volume provided the (constant)
+          // speed by which its size increases
+          cell->ChangeVolume(this->GetGrowthRate());
+        }
+      } else {
+        Log::Fatal("LegacyGrowth::Run", "Agent is not a Cell");
+      }
+    }
+
+    real_t GetThreshold() const { return threshold_; }
+    real_t GetGrowthRate() const { return growth_rate_; }
+
+  private:
+    real_t threshold_ = 10.0;
+    real_t growth_rate_ = 1.0;
+};
+
+
+class LegacyMigration : public Behavior {
+  BDM_BEHAVIOR_HEADER(LegacyMigration, Behavior, 1);
+
+  public:
+    LegacyMigration() { AlwaysCopyToNew(); }
+    LegacyMigration(real_t migration_rate, real_t propability, bool stick2boundary, bool grow2boundary)
+      : migration_rate_(migration_rate), propability_(propability), stick_to_boundary_(stick2boundary), grow_on_boundary_(grow2boundary) {}
+
+    virtual ~LegacyMigration() = default;
+
+    void Initialize(const NewAgentEvent& event) override {
+      // https://biodynamo.github.io/api/structbdm_1_1NewAgentEvent.html
+      Base::Initialize(event);
+
+      // if cell divides then behavior attributes have to be initialized
+      if (auto* b = dynamic_cast<LegacyMigration*>(event.existing_behavior)) {
         migration_rate_ = b->GetMigrationRate();
         propability_ = b->GetPropability();
         stick_to_boundary_ = b->GetStickToBoundary();
+        grow_on_boundary_ = b->GetGrowOnBoundary();
       } else {
-        Log::Fatal("MyMigration::Initialize",
-                   "event.existing_behavior was not of type MyMigration");
+        Log::Fatal("LegacyMigration::Initialize",
+                   "event.existing_behavior was not of type LegacyMigration");
       }
     }
 
@@ -99,34 +152,34 @@ class MyMigration : public Behavior {
             if (this->GetStickToBoundary()) {
               // in this case then simply freeze the cell on the boundary
               // and never let it do anything else
+              // (examples "ex7" to "ex9" let it grow from now on)
+              const bool grow = this->GetGrowOnBoundary();
               cell->RemoveBehavior(this);
-
-              // NOTE: not a good strategy to provide model parameter values
-              //       nested in the code; makes control of these parameters
-              //       a great challenge
-              real_t max_diameter = 4.0;
-              real_t volume_growth_rate = 0.1;
-              // check the 'my_growth.h' header file as well for more
-              // info about this cell behavior
-              cell->AddBehavior(new MyGrowth(max_diameter, volume_growth_rate));
+              if (grow) {
+                real_t max_diameter = 4.0;
+                real_t volume_growth_rate = 0.1;
+                cell->AddBehavior(new LegacyGrowth(max_diameter, volume_growth_rate));
+              }
             }
           }
         }
       } else {
-        Log::Fatal("MyMigration::Run", "Agent is not a Cell");
+        Log::Fatal("LegacyMigration::Run", "Agent is not a Cell");
       }
     }
 
     real_t GetMigrationRate() const { return migration_rate_; }
     real_t GetPropability() const { return propability_; }
     bool GetStickToBoundary() const { return stick_to_boundary_; }
+    bool GetGrowOnBoundary() const { return grow_on_boundary_; }
 
   private:
     real_t migration_rate_ = 1.0;
     real_t propability_ = 1.000;
     bool stick_to_boundary_ = false;
+    bool grow_on_boundary_ = false;
 };
 
 } // namespace bdm
 
-#endif // MY_MIGRATION_H_
+#endif // LEGACY_BEHAVIORS_H_
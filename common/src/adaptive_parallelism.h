@@ -0,0 +1,191 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef ADAPTIVE_PARALLELISM_H_
+#define ADAPTIVE_PARALLELISM_H_
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+Model of the cost of a time step, from the past ones: the work per agent
+(in nanoseconds of a single thread) is estimated from the wall time of the
+last time step times its number of threads, i.e., as if it scaled
+perfectly; the fork and join of threads that do next to nothing are thus
+counted as work, which drives the number of threads down until every
+thread has enough work to pay for them.
+*/
+struct ParallelCost {
+  real_t work_per_agent = 0.0;
+  int threads = 0;
+  uint64_t chunk = 0;
+
+  void Record(real_t wall_ns, int threads_used, uint64_t agents) {
+    const real_t work = wall_ns * threads_used / std::max<uint64_t>(agents, 1);
+    // smoothed over the last few time steps
+    work_per_agent = work_per_agent > 0.0 ? 0.7 * work_per_agent + 0.3 * work : work;
+  }
+
+  /*
+  Number of threads for the given number of agents such that every thread
+  does at least 'min_work' nanoseconds of work (all of them until measured).
+  The current number is kept unless the ideal (fractional) number of threads
+  is off by more than a margin of at least one thread (a quarter of them for
+  many threads), so that it does not flip between neighboring values, e.g.
+  between one and two threads while there are few agents.
+  */
+  int Threads(uint64_t agents, int max_threads, real_t min_work) const {
+    if (work_per_agent <= 0.0) return max_threads;
+    const real_t ideal = std::min<real_t>(agents * work_per_agent / min_work, max_threads);
+    const int proposed = std::clamp(static_cast<int>(ideal), 1, max_threads);
+    const real_t margin = std::max(1.0, 0.25 * threads);
+    if (threads > 0 && std::abs(ideal - threads) <= margin) return threads;
+    return proposed;
+  }
+};
+
+/*
+Sets the number of agents per chunk of the dynamic scheduling of the agent
+operations by the simulation engine. The parameters of a running simulation
+are const, but the engine reads 'scheduling_batch_size' anew whenever it
+starts its loop over the agents (nothing caches it), hence changing it
+between two time steps takes effect with the next one and is otherwise
+harmless; no other parameter is changed this way.
+*/
+inline void SetSchedulingBatchSize(Simulation* sim, uint64_t batch_size) {
+  const_cast<Param*>(sim->GetParam())->scheduling_batch_size = batch_size;
+}
+
+/*
+Opt-in choice of the parallel execution of the time steps, for simulations
+whose number of agents changes by orders of magnitude, e.g. from a single
+cell dividing (examples "ex03" to "ex05"): while there are few agents the
+fork and join of the threads costs more than the work itself. At the end of
+every time step, the number of threads of the next one is picked from the
+number of agents and the measured cost of the time steps (see
+'ParallelCost'), down to a serial time step, as well as the number of
+agents per chunk of the engine's dynamic scheduling of the agent operations
+('scheduling_batch_size': a few chunks per thread, at most the value of the
+simulation, see 'SetSchedulingBatchSize'). The number of threads changes
+only between time steps, hence all operations of a time step run on the
+same threads; if it changes on a machine of several NUMA domains, the
+agents are distributed anew among the domains as their threads changed.
+The decisions are logged whenever they change. Enabled by the command line
+option '--adaptive-parallelism' of the examples (see the 'scenario.h'
+header file).
+Usage:
+  auto* adaptive = new AdaptiveParallelism();
+  adaptive->Install(sim.GetScheduler());
+*/
+class AdaptiveParallelism : public StandaloneOperationImpl {
+  BDM_OP_HEADER(AdaptiveParallelism);
+
+  public:
+    // the minimum work (nanoseconds of a single thread) worth a thread
+    explicit AdaptiveParallelism(real_t min_work_per_thread = 50000.0)
+      : min_work_(min_work_per_thread), max_threads_(omp_get_max_threads()) {}
+
+    /*
+    Schedules the start of the time step before, and this operation (which
+    picks the threads of the next one) after, every time step.
+    */
+    void Install(Scheduler* scheduler) {
+      max_chunk_ = Simulation::GetActive()->GetParam()->scheduling_batch_size;
+      auto* start = new Operation("adaptive parallelism start");
+      start->AddOperationImpl(kCpu, new StartOfStep(this));
+      scheduler->ScheduleOp(start, OpType::kPreSchedule);
+      auto* op = new Operation("adaptive parallelism");
+      op->AddOperationImpl(kCpu, this);
+      scheduler->ScheduleOp(op, OpType::kPostSchedule);
+    }
+
+    // picks the threads of the next time step
+    void operator()() override {
+      auto* sim = Simulation::GetActive();
+      auto* rm = sim->GetResourceManager();
+      const uint64_t agents = rm->GetNumAgents();
+      const uint64_t step = sim->GetScheduler()->GetSimulatedSteps();
+      if (step_start_ > 0.0) {
+        cost_.Record(Now() - step_start_, omp_get_max_threads(), step_agents_);
+      }
+
+      const int threads = cost_.Threads(agents, max_threads_, min_work_);
+      const uint64_t chunk = std::clamp<uint64_t>(agents / (threads * kChunksPerThread), 1,
+                                                  max_chunk_);
+      if (threads != cost_.threads || chunk != cost_.chunk) {
+        Log::Info("AdaptiveParallelism", "step ", step, ", ", agents, " agents of ",
+                  std::lround(cost_.work_per_agent), " ns: ", threads,
+                  threads == 1 ? " thread" : " threads", ", ", chunk, " agents per chunk");
+      }
+      cost_.threads = threads;
+      cost_.chunk = chunk;
+      SetSchedulingBatchSize(sim, chunk);
+      if (threads != omp_get_max_threads()) {
+        omp_set_num_threads(threads);
+        // the engine distributes the agents among the threads it knows of
+        // https://biodynamo.github.io/api/classbdm_1_1ThreadInfo.html
+        auto* thread_info = ThreadInfo::GetInstance();
+        thread_info->Renew();
+        // ...and among the NUMA domains by their threads; the environment
+        // is built anew from the moved agents by the next time step
+        // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
+        if (thread_info->GetNumaNodes() > 1) rm->LoadBalance();
+      }
+    }
+
+  private:
+    // agents per chunk: enough chunks for the threads to balance their work
+    static constexpr uint64_t kChunksPerThread = 8;
+
+    static real_t Now() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // marks the start of a time step
+    class StartOfStep : public StandaloneOperationImpl {
+      BDM_OP_HEADER(StartOfStep);
+
+      public:
+        StartOfStep() = default;
+        explicit StartOfStep(AdaptiveParallelism* adaptive) : adaptive_(adaptive) {}
+
+        void operator()() override {
+          adaptive_->step_agents_ =
+              Simulation::GetActive()->GetResourceManager()->GetNumAgents();
+          adaptive_->step_start_ = Now();
+        }
+
+      private:
+        AdaptiveParallelism* adaptive_ = nullptr;
+    };
+
+    real_t min_work_ = 50000.0;
+    int max_threads_ = 1;
+    uint64_t max_chunk_ = 1000;
+    // the cost of the time steps, and the one in progress
+    ParallelCost cost_;
+    uint64_t step_agents_ = 0;
+    real_t step_start_ = 0.0;
+};
+
+} // namespace bdm
+
+#endif // ADAPTIVE_PARALLELISM_H_
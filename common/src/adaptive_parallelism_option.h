@@ -0,0 +1,53 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef ADAPTIVE_PARALLELISM_OPTION_H_
+#define ADAPTIVE_PARALLELISM_OPTION_H_
+
+#include "biodynamo.h"
+#include "adaptive_parallelism.h"
+#include "scenario.h"
+
+namespace bdm {
+
+/*
+Option of the scenario (see the 'scenario.h' header file) for the
+populations that grow from a single cell (examples "ex03" to "ex05"):
+  --adaptive-parallelism
+             picks the number of threads (down to one) of every time step
+             from the number of agents and the measured cost of the time
+             steps, and logs its decisions (see the 'adaptive_parallelism.h'
+             header file)
+*/
+class AdaptiveParallelismOption : public ScenarioOption {
+  public:
+    explicit AdaptiveParallelismOption(CommandLineOptions* clo) {
+      clo->AddOption<bool>("adaptive-parallelism", "false", "Pick the number of threads of every time step from the number of agents");
+    }
+
+    void Apply(const Scenario&, CommandLineOptions* clo, Param*) override {
+      enabled_ = clo->Get<bool>("adaptive-parallelism");
+    }
+
+    void Install(const Scenario&, Simulation* sim, uint64_t*) override {
+      // the scheduler takes over the adaptive parallelism operation
+      if (enabled_) (new AdaptiveParallelism())->Install(sim->GetScheduler());
+    }
+
+  private:
+    bool enabled_ = false;
+};
+
+} // namespace bdm
+
+#endif // ADAPTIVE_PARALLELISM_OPTION_H_
@@ -0,0 +1,172 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef ADI_GRID_H_
+#define ADI_GRID_H_
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+#include "dirichlet_boundary.h"
+
+namespace bdm {
+
+/*
+Lattice of a substance solved by an alternating direction implicit (ADI)
+scheme: every time step takes three sweeps, each of them implicit (backward
+Euler) along one axis, i.e., a tridiagonal system per line of voxels along
+that axis, solved by the Thomas algorithm in parallel over the lines (the
+locally one-dimensional splitting of BioFVM). As opposed to the explicit
+finite differences of the simulation engine, whose time step is limited by
+dt < h^2 / (6 * diffusion coefficient), the scheme is stable for any time
+step, it keeps the concentrations positive and it damps the short
+wavelengths; it is first order accurate in time, as the explicit one.
+The decay is applied by the exact factor exp(-decay_constant * dt).
+Selected with 'param->diffusion_method = "adi"' (see the 'substances.h'
+header file); periodic boundaries are not supported.
+*/
+class AdiGrid : public DiffusionGrid {
+  public:
+    AdiGrid() = default;
+    AdiGrid(int substance_id, const std::string& substance_name, real_t diffusion_coeff,
+            real_t decay_constant, int resolution = 10)
+      : DiffusionGrid(substance_id, substance_name, diffusion_coeff, decay_constant, resolution),
+        diffusion_coeff_(diffusion_coeff) {}
+
+    // the stability check of the explicit solver does not apply
+    void Step(real_t dt) override {
+      Diffuse(dt);
+      // https://biodynamo.github.io/api/classbdm_1_1DiffusionGrid.html
+      if (Simulation::GetActive()->GetParam()->calculate_gradients) CalculateGradient();
+    }
+
+    void DiffuseWithClosedEdge(real_t dt) override { Solve(dt, Edge::kMirror); }
+    void DiffuseWithNeumann(real_t dt) override { Solve(dt, Edge::kMirror); }
+    void DiffuseWithOpenEdge(real_t dt) override { Solve(dt, Edge::kZero); }
+    void DiffuseWithDirichlet(real_t dt) override {
+      Solve(dt, Edge::kFixed);
+      SetDirichletBoundary(*this, GetSimulatedTime(), &c1_);
+    }
+    void DiffuseWithPeriodic(real_t dt) override {
+      Log::Fatal("AdiGrid::DiffuseWithPeriodic", "periodic boundaries are not supported");
+    }
+
+  private:
+    /*
+    Concentration outside the lattice: the same as on the boundary (zero
+    flux, as for closed and Neumann boundaries), zero (open boundaries), or
+    none as the boundary voxels are fixed (Dirichlet boundaries).
+    */
+    enum class Edge { kMirror, kZero, kFixed };
+
+    /*
+    LU factorization of the (same) tridiagonal matrix of every line, i.e.,
+    I - r * (second difference), with r = D * dt / h^2: the sub-diagonal,
+    the super-diagonal divided by the pivot, and the inverse of the pivot.
+    */
+    void Factorize(real_t r, Edge edge) {
+      const size_t n = resolution_;
+      if (r == factorized_r_ && edge == factorized_edge_ && lower_.size() == n) return;
+      factorized_r_ = r;
+      factorized_edge_ = edge;
+      std::vector<real_t> diagonal(n, 1.0 + 2.0 * r);
+      std::vector<real_t> upper(n, -r);
+      lower_.assign(n, -r);
+      upper_.assign(n, 0.0);
+      inverse_.assign(n, 0.0);
+      if (edge == Edge::kMirror) {
+        diagonal[0] = diagonal[n - 1] = 1.0 + r;
+      } else if (edge == Edge::kFixed) {
+        diagonal[0] = diagonal[n - 1] = 1.0;
+        upper[0] = lower_[n - 1] = 0.0;
+      }
+      lower_[0] = upper[n - 1] = 0.0;
+      for (size_t k = 0; k < n; ++k) {
+        inverse_[k] = 1.0 / (diagonal[k] - (k > 0 ? lower_[k] * upper_[k - 1] : 0.0));
+        upper_[k] = upper[k] * inverse_[k];
+      }
+    }
+
+    void Solve(real_t dt, Edge edge) {
+      const size_t n = resolution_;
+      const size_t nn = n * n;
+      Factorize(diffusion_coeff_ * dt / (box_length_ * box_length_), edge);
+      const real_t decay = std::exp(-mu_ * dt);
+      const real_t* u = c1_.data();
+      real_t* v = c2_.data();
+      const real_t* lower = lower_.data();
+      const real_t* upper = upper_.data();
+      const real_t* inverse = inverse_.data();
+
+      // along x, one (contiguous) line at a time
+#pragma omp parallel for schedule(static)
+      for (size_t line = 0; line < nn; ++line) {
+        const real_t* b = u + n * line;
+        real_t* w = v + n * line;
+        w[0] = b[0] * inverse[0];
+        for (size_t x = 1; x < n; ++x) w[x] = (b[x] - lower[x] * w[x - 1]) * inverse[x];
+        for (size_t x = n - 1; x-- > 0;) w[x] -= upper[x] * w[x + 1];
+      }
+      // along y, all lines of a z plane at once, so that the innermost loops
+      // run over contiguous voxels
+#pragma omp parallel for schedule(static)
+      for (size_t z = 0; z < n; ++z) {
+        SolveLines(v + nn * z, n, n, lower, upper, inverse, 1.0);
+      }
+      // along z, all lines of a y plane at once, followed by the decay
+#pragma omp parallel for schedule(static)
+      for (size_t y = 0; y < n; ++y) {
+        SolveLines(v + n * y, n, nn, lower, upper, inverse, decay);
+      }
+      c1_.swap(c2_);
+    }
+
+    /*
+    Solves in place the n lines that start at w[0], ..., w[n-1] and run
+    along 'stride', and scales the solution.
+    */
+    static void SolveLines(real_t* w, size_t n, size_t stride, const real_t* lower,
+                           const real_t* upper, const real_t* inverse, real_t scale) {
+#pragma omp simd
+      for (size_t x = 0; x < n; ++x) w[x] *= inverse[0];
+      for (size_t k = 1; k < n; ++k) {
+        real_t* line = w + k * stride;
+        const real_t* previous = line - stride;
+#pragma omp simd
+        for (size_t x = 0; x < n; ++x) line[x] = (line[x] - lower[k] * previous[x]) * inverse[k];
+      }
+      real_t* last = w + (n - 1) * stride;
+#pragma omp simd
+      for (size_t x = 0; x < n; ++x) last[x] *= scale;
+      for (size_t k = n - 1; k-- > 0;) {
+        real_t* line = w + k * stride;
+        const real_t* next = line + stride;
+#pragma omp simd
+        for (size_t x = 0; x < n; ++x) line[x] = scale * line[x] - upper[k] * next[x];
+      }
+    }
+
+    real_t diffusion_coeff_ = 0.0;
+    // factorization of the tridiagonal matrix for r = D * dt / h^2
+    real_t factorized_r_ = -1.0;
+    Edge factorized_edge_ = Edge::kMirror;
+    std::vector<real_t> lower_, upper_, inverse_;
+
+    BDM_CLASS_DEF_OVERRIDE(AdiGrid, 1);
+};
+
+} // namespace bdm
+
+#endif // ADI_GRID_H_
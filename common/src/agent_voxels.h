@@ -0,0 +1,89 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef AGENT_VOXELS_H_
+#define AGENT_VOXELS_H_
+
+#include <memory>
+#include <vector>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+The voxels of a lattice that hold an agent (in no particular order), at the
+current and at the previous update, for the lattices that keep the
+concentration seen by the agents up to date only where they are (see the
+'mixed_precision_grid.h', 'fused_substance_grid.h' and 'sparse_grid.h'
+header files).
+The voxels of the agents are collected in parallel, per thread, and merged
+through a mark per voxel of the lattice, without sorting them.
+*/
+class AgentVoxels {
+  public:
+    void Update(const DiffusionGrid& grid) {
+      before_.swap(now_);
+      now_.clear();
+      auto* tinfo = ThreadInfo::GetInstance();
+      if (threads_.size() != static_cast<size_t>(tinfo->GetMaxThreads())) {
+        threads_.resize(tinfo->GetMaxThreads());
+        for (auto& thread : threads_) thread = std::make_shared<std::vector<size_t>>();
+      }
+      // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
+      auto collect = L2F([&](Agent* agent) {
+        threads_[tinfo->GetMyThreadId()]->push_back(grid.GetBoxIndex(agent->GetPosition()));
+      });
+      Simulation::GetActive()->GetResourceManager()->ForEachAgentParallel(collect);
+
+      marked_.resize(grid.GetNumBoxes(), false);
+      for (auto& thread : threads_) {
+        for (size_t i : *thread) Mark(i, &now_);
+        thread->clear();
+      }
+      either_ = now_;
+      for (size_t i : before_) Mark(i, &either_);
+      // no voxel stays marked between updates
+      for (size_t i : either_) marked_[i] = false;
+    }
+
+    void Clear() {
+      now_.clear();
+      before_.clear();
+      either_.clear();
+    }
+
+    // the voxels of the agents now
+    const std::vector<size_t>& Now() const { return now_; }
+    // the voxels of the agents now or at the previous update
+    const std::vector<size_t>& NowOrBefore() const { return either_; }
+
+  private:
+    // appends voxel i to the voxels, unless it is marked already
+    void Mark(size_t i, std::vector<size_t>* voxels) {
+      if (marked_[i]) return;
+      marked_[i] = true;
+      voxels->push_back(i);
+    }
+
+    std::vector<size_t> now_, before_, either_;
+    // whether a voxel is in the list being built
+    std::vector<bool> marked_;
+    // voxels of the agents collected by a thread (allocated separately,
+    // hence no false sharing)
+    std::vector<std::shared_ptr<std::vector<size_t>>> threads_;
+};
+
+} // namespace bdm
+
+#endif // AGENT_VOXELS_H_
@@ -0,0 +1,327 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef ASYNC_VISUALIZATION_H_
+#define ASYNC_VISUALIZATION_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "biodynamo.h"
+#include "counter_random.h"
+#include "mixed_precision_grid.h"
+#include "substances.h"
+
+namespace bdm {
+
+/*
+Export of the visualization data in a background thread, instead of the
+(blocking) export of the simulation engine: every 'interval' time steps the
+position, diameter and volume of all cells (and optionally an integer
+attribute, e.g. the phenotype) and the concentrations of the given
+substances are copied into a snapshot, which a writer thread serializes to
+ParaView files (a '.vtp' file of the agents and a '.vti' file per substance,
+listed in '.pvd' files) while the next time steps are computed.
+The snapshots are drawn from a fixed pool (by default two, i.e., a double
+buffer) whose arrays are reused, hence if the writer falls behind, the
+simulation waits for it (back-pressure) instead of buffering more and more
+snapshots.
+Optionally the concentrations are exported as 16-bit integers (see
+'Quantize16' in the 'mixed_precision_grid.h' header file), a quarter of the
+size of doubles, together with the offset and scale that restore them.
+Usage:
+  auto* visualization = new AsyncVisualization(sim.GetOutputDir(), 10, {"TGF"});
+  visualization->Install(sim.GetScheduler());
+  sim.GetScheduler()->Simulate(steps);
+  visualization->Finish();
+*/
+class AsyncVisualization : public StandaloneOperationImpl {
+  BDM_OP_HEADER(AsyncVisualization);
+
+  public:
+    // integer attribute of an agent (e.g. its phenotype)
+    using Attribute = std::function<int(const Agent*)>;
+
+    AsyncVisualization() = default;
+    AsyncVisualization(const std::string& dir, uint64_t interval,
+                       const std::vector<std::string>& substances, size_t num_snapshots = 2)
+      : interval_(std::max<uint64_t>(interval, 1)), substances_(substances),
+        writer_(std::make_shared<Writer>(dir, std::max<size_t>(num_snapshots, 1))) {}
+
+    // exports also the given attribute of every agent
+    void SetAttribute(const std::string& name, const Attribute& attribute) {
+      writer_->attribute_name = name;
+      attribute_ = attribute;
+    }
+
+    // exports the concentrations as 16-bit integers
+    void SetQuantized(bool quantized) { quantized_ = quantized; }
+
+    // schedules the export after every time step
+    void Install(Scheduler* scheduler) {
+      auto* op = new Operation("async visualization");
+      op->AddOperationImpl(kCpu, this);
+      scheduler->ScheduleOp(op, OpType::kPostSchedule);
+    }
+
+    void operator()() override {
+      auto* sim = Simulation::GetActive();
+      const uint64_t step = CounterRandom::GetStep(sim) + 1;
+      if (step % interval_ != 0) return;
+
+      // waits while all snapshots are queued for writing
+      Snapshot* snapshot = writer_->Acquire();
+      snapshot->step = step;
+      auto* rm = sim->GetResourceManager();
+      const size_t n = rm->GetNumAgents();
+      snapshot->position.resize(3 * n);
+      snapshot->diameter.resize(n);
+      snapshot->volume.resize(n);
+      snapshot->attribute.resize(attribute_ ? n : 0);
+      size_t i = 0;
+      // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
+      rm->ForEachAgent([&](Agent* agent) {
+        const auto* cell = bdm_static_cast<const Cell*>(agent);
+        const Real3& xyz = cell->GetPosition();
+        for (int d = 0; d < 3; ++d) snapshot->position[3 * i + d] = xyz[d];
+        snapshot->diameter[i] = cell->GetDiameter();
+        snapshot->volume[i] = cell->GetVolume();
+        if (attribute_) snapshot->attribute[i] = attribute_(agent);
+        ++i;
+      });
+
+      snapshot->grids.resize(substances_.size());
+      for (size_t g = 0; g < substances_.size(); ++g) {
+        auto* grid = rm->GetDiffusionGrid(substances_[g]);
+        auto& copy = snapshot->grids[g];
+        copy.name = substances_[g];
+        copy.resolution = grid->GetResolution();
+        copy.box_length = grid->GetBoxLength();
+        for (int d = 0; d < 3; ++d) copy.origin[d] = grid->GetDimensions()[2 * d];
+        SynchronizeConcentration(grid);
+        const real_t* c = grid->GetAllConcentrations();
+        if (quantized_) {
+          copy.quantized.resize(grid->GetNumBoxes());
+          copy.quantization = Quantize16(c, grid->GetNumBoxes(), copy.quantized.data());
+          copy.concentration.clear();
+        } else {
+          copy.concentration.assign(c, c + grid->GetNumBoxes());
+          copy.quantized.clear();
+        }
+      }
+      writer_->Submit(snapshot);
+    }
+
+    // waits until all snapshots are written
+    void Finish() { writer_->Finish(); }
+
+  private:
+    struct Grid {
+      std::string name;
+      size_t resolution = 0;
+      real_t box_length = 1.0;
+      real_t origin[3] = {0.0, 0.0, 0.0};
+      std::vector<real_t> concentration;
+      // if quantized instead: concentration = offset + scale * quantized
+      std::vector<uint16_t> quantized;
+      Quantization quantization;
+    };
+    struct Snapshot {
+      uint64_t step = 0;
+      std::vector<real_t> position, diameter, volume;
+      std::vector<int32_t> attribute;
+      std::vector<Grid> grids;
+    };
+
+    /*
+    Pool of snapshots shared with the writer thread: a snapshot is either
+    free, filled by the simulation, queued or written.
+    */
+    class Writer {
+      public:
+        Writer(const std::string& dir, size_t num_snapshots)
+          : dir_(dir), pool_(num_snapshots) {
+          for (auto& snapshot : pool_) free_.push_back(&snapshot);
+        }
+        ~Writer() { Finish(); }
+
+        Snapshot* Acquire() {
+          std::unique_lock<std::mutex> lock(mutex_);
+          if (!thread_.joinable()) thread_ = std::thread([this]() { Loop(); });
+          changed_.wait(lock, [this]() { return !free_.empty(); });
+          Snapshot* snapshot = free_.front();
+          free_.pop_front();
+          return snapshot;
+        }
+
+        void Submit(Snapshot* snapshot) {
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(snapshot);
+          }
+          changed_.notify_all();
+        }
+
+        void Finish() {
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+          }
+          changed_.notify_all();
+          if (thread_.joinable()) thread_.join();
+          std::lock_guard<std::mutex> lock(mutex_);
+          done_ = false;
+        }
+
+        std::string attribute_name;
+
+      private:
+        void Loop() {
+          std::unique_lock<std::mutex> lock(mutex_);
+          while (true) {
+            changed_.wait(lock, [this]() { return done_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            Snapshot* snapshot = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+            Write(*snapshot);
+            lock.lock();
+            free_.push_back(snapshot);
+            changed_.notify_all();
+          }
+        }
+
+        void Write(const Snapshot& snapshot) {
+          const std::string step = std::to_string(snapshot.step);
+          WriteAgents(dir_ + "/agents-" + step + ".vtp", snapshot);
+          AddToCollection("agents", snapshot.step, "agents-" + step + ".vtp");
+          for (const auto& grid : snapshot.grids) {
+            WriteGrid(dir_ + "/" + grid.name + "-" + step + ".vti", grid);
+            AddToCollection(grid.name, snapshot.step, grid.name + "-" + step + ".vti");
+          }
+        }
+
+        // VTK XML files with their arrays appended (raw, little-endian)
+        static constexpr const char* kType = sizeof(real_t) == 8 ? "Float64" : "Float32";
+
+        void WriteAgents(const std::string& file, const Snapshot& s) const {
+          const size_t n = s.diameter.size();
+          std::ofstream out(file, std::ios::binary | std::ios::trunc);
+          // declares an appended array, whose data follow in the same order
+          uint64_t offset = 0;
+          auto array = [&](const char* type, const std::string& name, int components,
+                           uint64_t bytes) {
+            out << "<DataArray type=\"" << type << "\" Name=\"" << name
+                << "\" NumberOfComponents=\"" << components << "\" format=\"appended\""
+                << " offset=\"" << offset << "\"/>\n";
+            offset += sizeof(uint64_t) + bytes;
+          };
+          out << "<?xml version=\"1.0\"?>\n"
+              << "<VTKFile type=\"PolyData\" version=\"1.0\" byte_order=\"LittleEndian\""
+              << " header_type=\"UInt64\">\n<PolyData>\n<Piece NumberOfPoints=\"" << n
+              << "\" NumberOfVerts=\"0\" NumberOfLines=\"0\" NumberOfStrips=\"0\""
+              << " NumberOfPolys=\"0\">\n<PointData>\n";
+          array(kType, "diameter_", 1, n * sizeof(real_t));
+          array(kType, "volume_", 1, n * sizeof(real_t));
+          if (!s.attribute.empty()) array("Int32", attribute_name, 1, n * sizeof(int32_t));
+          out << "</PointData>\n<Points>\n";
+          array(kType, "position_", 3, 3 * n * sizeof(real_t));
+          out << "</Points>\n</Piece>\n</PolyData>\n<AppendedData encoding=\"raw\">\n_";
+          WriteArray(&out, s.diameter.data(), n);
+          WriteArray(&out, s.volume.data(), n);
+          if (!s.attribute.empty()) WriteArray(&out, s.attribute.data(), n);
+          WriteArray(&out, s.position.data(), 3 * n);
+          out << "\n</AppendedData>\n</VTKFile>\n";
+        }
+
+        static void WriteGrid(const std::string& file, const Grid& grid) {
+          const std::string extent = "0 " + std::to_string(grid.resolution - 1);
+          std::ofstream out(file, std::ios::binary | std::ios::trunc);
+          out << "<?xml version=\"1.0\"?>\n"
+              << "<VTKFile type=\"ImageData\" version=\"1.0\" byte_order=\"LittleEndian\""
+              << " header_type=\"UInt64\">\n<ImageData WholeExtent=\"" << extent << " "
+              << extent << " " << extent << "\" Origin=\"" << grid.origin[0] << " "
+              << grid.origin[1] << " " << grid.origin[2] << "\" Spacing=\"" << grid.box_length
+              << " " << grid.box_length << " " << grid.box_length << "\">\n<Piece Extent=\""
+              << extent << " " << extent << " " << extent << "\">\n";
+          const bool quantized = !grid.quantized.empty();
+          if (quantized) {
+            out << "<FieldData>\n<DataArray type=\"Float64\" Name=\"Quantization\""
+                << " NumberOfTuples=\"1\" NumberOfComponents=\"2\" format=\"ascii\">"
+                << grid.quantization.offset << " " << grid.quantization.scale
+                << "</DataArray>\n</FieldData>\n";
+          }
+          out << "<PointData Scalars=\"Substance_Concentration\">\n<DataArray type=\""
+              << (quantized ? "UInt16" : kType)
+              << "\" Name=\"Substance_Concentration\" format=\"appended\" offset=\"0\"/>\n"
+              << "</PointData>\n</Piece>\n</ImageData>\n<AppendedData encoding=\"raw\">\n_";
+          if (quantized) {
+            WriteArray(&out, grid.quantized.data(), grid.quantized.size());
+          } else {
+            WriteArray(&out, grid.concentration.data(), grid.concentration.size());
+          }
+          out << "\n</AppendedData>\n</VTKFile>\n";
+        }
+
+        template <typename T>
+        static void WriteArray(std::ofstream* out, const T* data, size_t count) {
+          const uint64_t bytes = count * sizeof(T);
+          out->write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+          out->write(reinterpret_cast<const char*>(data), bytes);
+        }
+
+        // (re)writes the ParaView collection of the files of a series
+        void AddToCollection(const std::string& series, uint64_t step, const std::string& file) {
+          auto& files = collections_[series];
+          files.push_back({step, file});
+          std::ofstream out(dir_ + "/" + series + ".pvd", std::ios::trunc);
+          out << "<?xml version=\"1.0\"?>\n<VTKFile type=\"Collection\" version=\"0.1\">\n"
+              << "<Collection>\n";
+          for (const auto& [t, f] : files) {
+            out << "<DataSet timestep=\"" << t << "\" file=\"" << f << "\"/>\n";
+          }
+          out << "</Collection>\n</VTKFile>\n";
+        }
+
+        std::string dir_;
+        std::vector<Snapshot> pool_;
+        std::deque<Snapshot*> free_, queue_;
+        std::map<std::string, std::vector<std::pair<uint64_t, std::string>>> collections_;
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::thread thread_;
+        bool done_ = false;
+    };
+
+    uint64_t interval_ = 1;
+    std::vector<std::string> substances_;
+    Attribute attribute_;
+    bool quantized_ = false;
+    std::shared_ptr<Writer> writer_;
+};
+
+} // namespace bdm
+
+#endif // ASYNC_VISUALIZATION_H_
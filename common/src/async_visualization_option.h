@@ -0,0 +1,81 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef ASYNC_VISUALIZATION_OPTION_H_
+#define ASYNC_VISUALIZATION_OPTION_H_
+
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+#include "async_visualization.h"
+#include "scenario.h"
+
+namespace bdm {
+
+/*
+Option of the scenario (see the 'scenario.h' header file) that exports the
+visualization data in a background thread (see the 'async_visualization.h'
+header file) instead of the simulation engine, which stops computing while
+it writes the files; the agent groups of the scenario are exported as the
+attribute '<name>_':
+  --async-visualization
+             replaces the export of the simulation engine (if enabled)
+  --quantize-visualization
+             exports the substance concentrations as 16-bit integers
+*/
+class AsyncVisualizationOption : public ScenarioOption {
+  public:
+    explicit AsyncVisualizationOption(CommandLineOptions* clo) {
+      clo->AddOption<bool>("async-visualization", "false", "Export the visualization in a background thread");
+      clo->AddOption<bool>("quantize-visualization", "false", "Export the substances of the asynchronous visualization as 16-bit integers");
+    }
+
+    void Apply(const Scenario&, CommandLineOptions* clo, Param* param) override {
+      quantized_ = clo->Get<bool>("quantize-visualization");
+      if (clo->Get<bool>("async-visualization") && param->export_visualization) {
+        // the export of the simulation engine is replaced by ours
+        param->export_visualization = false;
+        interval_ = param->visualization_interval;
+        for (const auto& substance : param->visualize_diffusion) {
+          substances_.push_back(substance.name);
+        }
+      }
+    }
+
+    void Install(const Scenario& scenario, Simulation* sim, uint64_t*) override {
+      if (interval_ == 0) return;
+      visualization_ = new AsyncVisualization(sim->GetOutputDir(), interval_, substances_);
+      if (scenario.GetGroup()) {
+        visualization_->SetAttribute(scenario.GetGroupName() + "_", scenario.GetGroup());
+      }
+      visualization_->SetQuantized(quantized_);
+      visualization_->Install(sim->GetScheduler());
+    }
+
+    // the files still queued for writing are part of the run
+    void Finish() override {
+      if (visualization_ != nullptr) visualization_->Finish();
+    }
+
+  private:
+    bool quantized_ = false;
+    // export interval (0 if disabled) and substances of the visualization
+    uint64_t interval_ = 0;
+    std::vector<std::string> substances_;
+    AsyncVisualization* visualization_ = nullptr;
+};
+
+} // namespace bdm
+
+#endif // ASYNC_VISUALIZATION_OPTION_H_
@@ -0,0 +1,240 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef BATCHED_MIGRATION_H_
+#define BATCHED_MIGRATION_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "biodynamo.h"
+#include "cell_migration.h"
+#include "counter_random.h"
+
+namespace bdm {
+
+/*
+Migration step of a batch of n agents stored as a structure of arrays. Every
+agent i still in the simulation (alive[i] is 1) is displaced by (dx[i],
+dy[i], dz[i]) and then (unless kBoundary is kNone) clamped within [min_b,
+max_b] shrunk by a margin of 0.55 times its diameter; the others (alive[i]
+is 0) are left untouched. The loop has no branches, so that it is
+vectorized; on return moved[i] and on_bound[i] are 1 if agent i migrated,
+respectively reached the boundary, and 0 otherwise.
+*/
+template <BoundaryMode kBoundary>
+inline void MigrateBatch(size_t n, real_t min_b, real_t max_b,
+                         const uint8_t* __restrict alive,
+                         const real_t* __restrict diameter,
+                         const real_t* __restrict dx,
+                         const real_t* __restrict dy,
+                         const real_t* __restrict dz,
+                         real_t* __restrict x, real_t* __restrict y,
+                         real_t* __restrict z,
+                         uint8_t* __restrict moved,
+                         uint8_t* __restrict on_bound) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) {
+    // the mask of the agents alive is kept as an arithmetic factor and
+    // selections are compiled to blends, i.e., the loop has no branches
+    const real_t m = alive[i] ? 1.0 : 0.0;
+    if constexpr (kBoundary == BoundaryMode::kNone) {
+      // exactly x[i] + dx[i] if the agent migrates
+      x[i] += m * dx[i];
+      y[i] += m * dy[i];
+      z[i] += m * dz[i];
+      on_bound[i] = 0;
+    } else {
+      const real_t lo = min_b + 0.55 * diameter[i];
+      const real_t hi = max_b - 0.55 * diameter[i];
+      const real_t px = x[i] + dx[i];
+      const real_t py = y[i] + dy[i];
+      const real_t pz = z[i] + dz[i];
+      const real_t cx = std::min(std::max(px, lo), hi);
+      const real_t cy = std::min(std::max(py, lo), hi);
+      const real_t cz = std::min(std::max(pz, lo), hi);
+      // agents no longer alive are left untouched
+      x[i] = m > 0.0 ? cx : x[i];
+      y[i] = m > 0.0 ? cy : y[i];
+      z[i] = m > 0.0 ? cz : z[i];
+      on_bound[i] = (m > 0.0) & ((cx != px) | (cy != py) | (cz != pz));
+    }
+    moved[i] = alive[i];
+  }
+}
+
+/*
+Alternative to the 'CellMigration' behavior: a standalone operation that
+migrates all agents added to it in one pass over contiguous arrays of their
+positions and diameters (see 'MigrateBatch' above), instead of calling a
+behavior per agent. As the behavior, every agent sleeps until the time step
+of its next move (see 'NextMigrationStep'): only the agents due in a time
+step are looked up and gathered, and agents that never move are not added
+at all. The agents added to this operation should not carry a migration
+behavior. Agents that stick to the boundary (kStick) are dropped from the
+batch, and then 'TOnStick' is called with each one of them.
+Usage:
+  auto* migration = new BatchedMigration<BoundaryMode::kStick>();
+  auto* op = new Operation("batched migration");
+  op->AddOperationImpl(kCpu, migration);
+  sim.GetScheduler()->ScheduleOp(op);
+  ...
+  migration->Add(cell, migration_rate, propability);
+*/
+template <BoundaryMode kBoundary = BoundaryMode::kNone,
+          typename TOnStick = NoStickAction>
+class BatchedMigration : public StandaloneOperationImpl {
+  BDM_OP_HEADER(BatchedMigration);
+
+  public:
+    BatchedMigration() = default;
+    explicit BatchedMigration(const TOnStick& on_stick) : on_stick_(on_stick) {}
+
+    // add a cell to the batch of migrating agents
+    void Add(Agent* cell, real_t migration_rate, real_t propability) {
+      if (propability <= 0.0) return;
+      auto* sim = Simulation::GetActive();
+      uids_.push_back(cell->GetUid());
+      migration_rate_.push_back(migration_rate);
+      propability_.push_back(propability);
+      next_step_.push_back(NextMigrationStep(sim->GetParam()->random_seed, cell->GetUid(),
+                                             CounterRandom::GetStep(sim), propability));
+    }
+
+    size_t GetNumAgents() const { return uids_.size(); }
+
+    void operator()() override {
+      auto* sim = Simulation::GetActive();
+      auto* rm = sim->GetResourceManager();
+      const auto* param = sim->GetParam();
+      const uint64_t step = CounterRandom::GetStep(sim);
+      const size_t n = uids_.size();
+
+      // the agents that move in this time step
+      due_.clear();
+      for (size_t i = 0; i < n; ++i) {
+        if (next_step_[i] <= step) due_.push_back(i);
+      }
+      const size_t m = due_.size();
+      Resize(m);
+
+      // draw the random numbers of this time step in bulk: the
+      // displacements and the waits until the next move; these are the
+      // very same numbers that the 'CellMigration' behavior draws (see
+      // 'CounterUniforms' in the 'counter_random.h' header file)
+      for (size_t j = 0; j < m; ++j) due_uids_[j] = uids_[due_[j]];
+      CounterUniforms(param->random_seed, due_uids_.data(), m, step, kMigrationStream, 3,
+                      displacement_.data());
+      CounterUniforms(param->random_seed, due_uids_.data(), m, step + 1, kMigrationTimeStream, 1,
+                      wait_.data());
+
+      // gather the agent data in contiguous arrays
+#pragma omp parallel for schedule(static)
+      for (size_t j = 0; j < m; ++j) {
+        const size_t i = due_[j];
+        Agent* agent = rm->ContainsAgent(uids_[i]) ? rm->GetAgent(uids_[i]) : nullptr;
+        agents_[j] = agent;
+        // the agents removed from the simulation do not move
+        alive_[j] = agent != nullptr;
+        if (agent == nullptr) continue;
+        const Real3& xyz = agent->GetPosition();
+        x_[j] = xyz[0];
+        y_[j] = xyz[1];
+        z_[j] = xyz[2];
+        diameter_[j] = agent->GetDiameter();
+        // uniform random numbers in [-delta, +delta)
+        const real_t delta = migration_rate_[i] * param->simulation_time_step;
+        dx_[j] = -delta + 2.0 * delta * displacement_[3 * j];
+        dy_[j] = -delta + 2.0 * delta * displacement_[3 * j + 1];
+        dz_[j] = -delta + 2.0 * delta * displacement_[3 * j + 2];
+        next_step_[i] = NextMigrationStep(step + 1, propability_[i], wait_[j]);
+      }
+
+      MigrateBatch<kBoundary>(m, param->min_bound, param->max_bound,
+                              alive_.data(), diameter_.data(),
+                              dx_.data(), dy_.data(), dz_.data(),
+                              x_.data(), y_.data(), z_.data(),
+                              moved_.data(), on_bound_.data());
+
+      // scatter the new positions of the agents that migrated
+#pragma omp parallel for schedule(static)
+      for (size_t j = 0; j < m; ++j) {
+        if (moved_[j]) {
+          agents_[j]->SetPosition({x_[j], y_[j], z_[j]});
+        }
+      }
+
+      // compact the batch, dropping the agents that were removed from the
+      // simulation and (kStick) those that stuck to the boundary
+      drop_.assign(n, 0);
+      for (size_t j = 0; j < m; ++j) {
+        const bool stuck = (kBoundary == BoundaryMode::kStick) && on_bound_[j];
+        if (agents_[j] == nullptr || stuck) {
+          if (stuck) on_stick_(bdm_static_cast<Cell*>(agents_[j]));
+          drop_[due_[j]] = 1;
+        }
+      }
+      size_t k = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (drop_[i]) continue;
+        uids_[k] = uids_[i];
+        migration_rate_[k] = migration_rate_[i];
+        propability_[k] = propability_[i];
+        next_step_[k] = next_step_[i];
+        ++k;
+      }
+      uids_.resize(k);
+      migration_rate_.resize(k);
+      propability_.resize(k);
+      next_step_.resize(k);
+    }
+
+  private:
+    void Resize(size_t m) {
+      due_uids_.resize(m);
+      displacement_.resize(3 * m);
+      wait_.resize(m);
+      agents_.resize(m);
+      x_.resize(m);
+      y_.resize(m);
+      z_.resize(m);
+      diameter_.resize(m);
+      alive_.resize(m);
+      dx_.resize(m);
+      dy_.resize(m);
+      dz_.resize(m);
+      moved_.resize(m);
+      on_bound_.resize(m);
+    }
+
+    TOnStick on_stick_;
+    // the batch of migrating agents, their parameters and the time step
+    // of their next move
+    std::vector<AgentUid> uids_;
+    std::vector<real_t> migration_rate_;
+    std::vector<real_t> propability_;
+    std::vector<uint64_t> next_step_;
+    // scratch arrays of every time step (of the agents due)
+    std::vector<size_t> due_;
+    std::vector<AgentUid> due_uids_;
+    std::vector<real_t> displacement_, wait_;
+    std::vector<Agent*> agents_;
+    std::vector<real_t> x_, y_, z_, diameter_;
+    std::vector<real_t> dx_, dy_, dz_;
+    std::vector<uint8_t> alive_, moved_, on_bound_, drop_;
+};
+
+} // namespace bdm
+
+#endif // BATCHED_MIGRATION_H_
@@ -0,0 +1,149 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef BATCHED_SECRETION_H_
+#define BATCHED_SECRETION_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+Alternative to a 'Secretion' behavior per agent: a standalone operation that
+deposits the secretion (positive quantity) and uptake (negative quantity)
+of all agents into the lattice of a substance at once. Every time step the
+agents are binned by their voxel, the quantities of the agents of every
+voxel are summed (in the order of their uids, hence the result does not
+depend on the number of threads nor on the order of the agents in memory)
+and the sums are added to the voxels in ascending order, i.e., one pass over
+the lattice instead of a lookup and a locked update per agent. The uptake
+of a voxel is clamped so that its concentration does not become negative.
+The sums (the source field) are cached: they are recomputed only if an
+agent moved to another voxel or changed its quantity, or if agents were
+added or removed, e.g. never for the static cells of example "ex10".
+The quantity of every agent (per time step, as for 'Secretion') is given by
+a function of the agent, e.g. of its phenotype, so that the agents carry no
+secretion behavior: agents added later (e.g. by division, or restored from
+a checkpoint) secrete as well.
+Usage:
+  auto* secretion = new BatchedSecretion("TGF", [](const Agent* agent) {
+    return ...;
+  });
+  auto* op = new Operation("batched secretion");
+  op->AddOperationImpl(kCpu, secretion);
+  sim.GetScheduler()->ScheduleOp(op);
+*/
+class BatchedSecretion : public StandaloneOperationImpl {
+  BDM_OP_HEADER(BatchedSecretion);
+
+  public:
+    // quantity secreted by an agent every time step (negative for uptake)
+    using Quantity = std::function<real_t(const Agent*)>;
+
+    BatchedSecretion() = default;
+    BatchedSecretion(const std::string& substance, const Quantity& quantity)
+      : substance_(substance), quantity_(quantity) {}
+
+    void operator()() override {
+      auto* rm = Simulation::GetActive()->GetResourceManager();
+      // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
+      auto* grid = rm->GetDiffusionGrid(substance_);
+      agents_.clear();
+      rm->ForEachAgent([&](Agent* agent) { agents_.push_back(agent); });
+      const size_t n = agents_.size();
+      deposits_.resize(n);
+
+      // bin the agents by voxel, checking whether any agent changed its
+      // voxel or quantity since the source field was computed
+      bool changed = n != sources_.size();
+#pragma omp parallel for schedule(static) reduction(||:changed)
+      for (size_t i = 0; i < n; ++i) {
+        const Agent* agent = agents_[i];
+        deposits_[i] = {grid->GetBoxIndex(agent->GetPosition()),
+                        agent->GetUid().GetIndex(), quantity_(agent)};
+        changed = changed || i >= sources_.size() || !(deposits_[i] == sources_[i]);
+      }
+      if (changed) {
+        sources_ = deposits_;
+        ComputeField();
+      }
+
+      // add the source field, clamped at zero
+      const real_t* c = grid->GetAllConcentrations();
+      for (size_t k = 0; k < field_voxels_.size(); ++k) {
+        const size_t voxel = field_voxels_[k];
+        const real_t amount = std::max(field_amounts_[k], -c[voxel]);
+        if (amount != 0.0) {
+          // https://biodynamo.github.io/api/classbdm_1_1DiffusionGrid.html
+          grid->ChangeConcentrationBy(voxel, amount);
+        }
+      }
+    }
+
+    // number of times the source field was (re)computed
+    uint64_t GetNumFieldUpdates() const { return num_field_updates_; }
+
+  private:
+    struct Deposit {
+      size_t voxel;
+      // index of the uid of the agent (unique among the agents)
+      AgentUid::Index_t index;
+      real_t quantity;
+
+      bool operator==(const Deposit& other) const {
+        return voxel == other.voxel && index == other.index && quantity == other.quantity;
+      }
+    };
+
+    // sum of the quantities of the agents of every voxel
+    void ComputeField() {
+      std::sort(deposits_.begin(), deposits_.end(), [](const Deposit& a, const Deposit& b) {
+        return a.voxel < b.voxel || (a.voxel == b.voxel && a.index < b.index);
+      });
+      field_voxels_.clear();
+      field_amounts_.clear();
+      for (size_t i = 0; i < deposits_.size();) {
+        const size_t voxel = deposits_[i].voxel;
+        real_t sum = 0.0;
+        for (; i < deposits_.size() && deposits_[i].voxel == voxel; ++i) {
+          sum += deposits_[i].quantity;
+        }
+        field_voxels_.push_back(voxel);
+        field_amounts_.push_back(sum);
+      }
+      ++num_field_updates_;
+    }
+
+    std::string substance_;
+    Quantity quantity_;
+    // scratch arrays of every time step
+    std::vector<Agent*> agents_;
+    std::vector<Deposit> deposits_;
+    // the deposits (in the order of the agents) the source field was
+    // computed from, and the source field: voxels in ascending order and
+    // their sums
+    std::vector<Deposit> sources_;
+    std::vector<size_t> field_voxels_;
+    std::vector<real_t> field_amounts_;
+    uint64_t num_field_updates_ = 0;
+};
+
+} // namespace bdm
+
+#endif // BATCHED_SECRETION_H_
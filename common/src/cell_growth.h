@@ -0,0 +1,94 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef CELL_GROWTH_H_
+#define CELL_GROWTH_H_
+
+#include <type_traits>
+
+#include "biodynamo.h"
+#include "core/behavior/behavior.h"
+#include "core/util/type.h"
+
+namespace bdm {
+
+/*
+Default action executed right after a cell has grown to its threshold.
+*/
+struct NoGrownAction {
+  void operator()(Agent* agent) const {}
+};
+
+/*
+Growth of a cell (by a constant volume rate) until its diameter reaches a
+threshold value. The agent type is a template parameter, thus, no
+'dynamic_cast' is needed in 'Run'.
+Optionally, a 'TOnGrown' functor can be provided; then once the cell has
+grown the behavior is removed from it and the functor is called with the
+cell (e.g. to freeze it, see the 'dormant_tier.h' header file).
+*/
+template <typename TAgent = Cell, typename TOnGrown = NoGrownAction>
+class CellGrowth : public Behavior {
+  BDM_BEHAVIOR_HEADER(CellGrowth, Behavior, 1);
+
+  public:
+    CellGrowth() { AlwaysCopyToNew(); }
+    CellGrowth(real_t threshold, real_t growth_rate,
+               const TOnGrown& on_grown = TOnGrown())
+      : threshold_(threshold), growth_rate_(growth_rate), on_grown_(on_grown) {}
+
+    virtual ~CellGrowth() = default;
+
+    void Initialize(const NewAgentEvent& event) override {
+      // https://biodynamo.github.io/api/structbdm_1_1NewAgentEvent.html
+      Base::Initialize(event);
+
+      // if cell divides then behavior attributes have to be initialized
+      if (auto* b = dynamic_cast<CellGrowth*>(event.existing_behavior)) {
+        threshold_ = b->GetThreshold();
+        growth_rate_ = b->GetGrowthRate();
+        on_grown_ = b->on_grown_;
+      } else {
+        Log::Fatal("CellGrowth::Initialize",
+                   "event.existing_behavior was not of type CellGrowth");
+      }
+    }
+
+    void Run(Agent* agent) override {
+      auto* cell = bdm_static_cast<TAgent*>(agent);
+      // check if cell diameter is below a fixed threshold value
+      if (cell->GetDiameter() <= threshold_) {
+        // now increase the cell volume provided the (constant)
+        // speed by which its size increases
+        cell->ChangeVolume(growth_rate_);
+      } else if constexpr (!std::is_same<TOnGrown, NoGrownAction>::value) {
+        // the behavior is deleted once removed from the cell,
+        // hence keep a copy of the action to perform afterwards
+        TOnGrown on_grown = on_grown_;
+        cell->RemoveBehavior(this);
+        on_grown(cell);
+      }
+    }
+
+    real_t GetThreshold() const { return threshold_; }
+    real_t GetGrowthRate() const { return growth_rate_; }
+
+  private:
+    real_t threshold_ = 10.0;
+    real_t growth_rate_ = 1.0;
+    TOnGrown on_grown_;
+};
+
+} // namespace bdm
+
+#endif // CELL_GROWTH_H_
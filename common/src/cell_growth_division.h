@@ -0,0 +1,126 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef CELL_GROWTH_DIVISION_H_
+#define CELL_GROWTH_DIVISION_H_
+
+#include <type_traits>
+
+#include "biodynamo.h"
+#include "core/behavior/behavior.h"
+#include "core/util/type.h"
+#include "counter_random.h"
+
+namespace bdm {
+
+/*
+Default (no) contact inhibition: a cell never stops growing and dividing.
+*/
+struct NoContactInhibition {
+  bool operator()(Agent* agent) const { return false; }
+};
+
+/*
+Growth of a cell (by a constant volume rate) until its diameter reaches a
+threshold value; after that, in every successive time step, the cell divides
+if a uniform random number is below a propability value. The daughter cell
+inherits (a copy of) every behavior of the mother cell.
+Optionally, a 'TInhibition' functor can be provided which is called with the
+cell first; if it returns true then the cell stops growing and dividing
+forever (see example "ex11").
+*/
+template <typename TAgent = Cell, typename TInhibition = NoContactInhibition>
+class CellGrowthDivision : public Behavior {
+  BDM_BEHAVIOR_HEADER(CellGrowthDivision, Behavior, 1);
+
+  public:
+    CellGrowthDivision() { AlwaysCopyToNew(); }
+    CellGrowthDivision(real_t threshold, real_t growth_rate, real_t propability,
+                       const TInhibition& inhibition = TInhibition())
+      : threshold_(threshold), growth_rate_(growth_rate), propability_(propability),
+        inhibition_(inhibition) {}
+
+    virtual ~CellGrowthDivision() = default;
+
+    void Initialize(const NewAgentEvent& event) override {
+      // https://biodynamo.github.io/api/structbdm_1_1NewAgentEvent.html
+      Base::Initialize(event);
+
+      // if cell divides then behavior attributes have to be initialized
+      if (auto* b = dynamic_cast<CellGrowthDivision*>(event.existing_behavior)) {
+        threshold_ = b->GetThreshold();
+        growth_rate_ = b->GetGrowthRate();
+        propability_ = b->GetPropability();
+        inhibition_ = b->GetInhibition();
+      } else {
+        Log::Fatal("CellGrowthDivision::Initialize",
+                   "event.existing_behavior was not of type CellGrowthDivision");
+      }
+    }
+
+    void Run(Agent* agent) override {
+      auto* cell = bdm_static_cast<TAgent*>(agent);
+
+      if constexpr (!std::is_same<TInhibition, NoContactInhibition>::value) {
+        // if the cell is inhibited (e.g. it is adjacent to another cell)
+        // then it simply stops from growing and dividing
+        if (inhibition_(cell)) {
+          cell->RemoveBehavior(this);
+          return;
+        }
+      }
+
+      // check if cell diameter is below a fixed threshold value
+      if (cell->GetDiameter() <= threshold_) {
+        // now increase the cell volume provided the (constant)
+        // speed by which its size increases
+        cell->ChangeVolume(growth_rate_);
+        return;
+      }
+      // otherwise check if a uniform random number is below the
+      // propability for the cell to split in two halves (divide); the
+      // random numbers of this cell at this time step do not depend on
+      // the number of threads (check the 'counter_random.h' header file)
+      auto rand = CounterRandom::ForAgent(cell, kDivisionStream);
+      if (rand.Uniform() <= propability_) {
+        // now activate the division of this cell and get access to the
+        // newly generated cell; the volume ratio and the division axis
+        // are drawn as by 'Cell::Divide()', but from the same stream
+        const real_t volume_ratio = rand.Uniform(0.9, 1.1);
+        const real_t phi = rand.Uniform(0.0, 2.0 * Math::kPi);
+        const real_t theta = rand.Uniform(0.0, Math::kPi);
+        auto* new_cell = cell->Divide(volume_ratio, phi, theta);
+        // and set for that new cell to have the same behaviors as
+        // the cell it originated from
+        // https://biodynamo.github.io/api/classbdm_1_1Agent.html#ac6ff7e2073bd2b3e4794bc8f0a8c26ed
+        for (const auto* b : cell->GetAllBehaviors()) {
+          new_cell->AddBehavior(b->NewCopy());
+        }
+      }
+    }
+
+    real_t GetThreshold() const { return threshold_; }
+    real_t GetGrowthRate() const { return growth_rate_; }
+    real_t GetPropability() const { return propability_; }
+    const TInhibition& GetInhibition() const { return inhibition_; }
+
+  private:
+    real_t threshold_ = 10.0;
+    real_t growth_rate_ = 1.0;
+    real_t propability_ = 1.000;
+    TInhibition inhibition_;
+};
+
+} // namespace bdm
+
+#endif // CELL_GROWTH_DIVISION_H_
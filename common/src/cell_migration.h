@@ -0,0 +1,186 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef CELL_MIGRATION_H_
+#define CELL_MIGRATION_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "biodynamo.h"
+#include "core/behavior/behavior.h"
+#include "core/util/type.h"
+#include "counter_random.h"
+
+namespace bdm {
+
+/*
+What happens to a migrating cell once it crosses the simulation domain
+boundaries (shrunk by a margin of 0.55 times the cell diameter):
+  kNone  - nothing, the cell is free to move (see examples "ex5", "ex11")
+  kClamp - the cell is projected back onto the boundary
+  kStick - the cell is projected back onto the boundary and it stops
+           migrating forever (see examples "ex6" to "ex9")
+*/
+enum class BoundaryMode { kNone, kClamp, kStick };
+
+/*
+Default action executed right after a cell sticks to the boundary.
+*/
+struct NoStickAction {
+  void operator()(Agent* agent) const {}
+};
+
+/*
+Time step at which a cell that migrates with the given propability per time
+step moves next, counting from time step 'step' (included): the number of
+time steps it waits is drawn once from the geometric distribution (see the
+'counter_random.h' header file), from the stream of the cell at time step
+'step', instead of a uniform random number every time step. The largest
+integer if the cell never moves.
+*/
+inline uint64_t NextMigrationStep(uint64_t step, real_t propability, real_t u) {
+  const uint64_t wait = GeometricSteps(propability, u);
+  return wait == std::numeric_limits<uint64_t>::max() ? wait : step + wait - 1;
+}
+inline uint64_t NextMigrationStep(uint64_t seed, const AgentUid& uid, uint64_t step,
+                                  real_t propability) {
+  CounterRandom rand(seed, uid, step, kMigrationTimeStream);
+  return NextMigrationStep(step, propability, rand.Uniform());
+}
+
+/*
+Random walk of a cell in 3D space. The agent type and the boundary mode are
+template parameters so that the hot path of 'Run' neither needs a
+'dynamic_cast' nor any branching on the (constant) behavior flags. Any
+(copyable) functor can be provided as 'TOnStick' to be called with the cell
+right after it stuck to the boundary, e.g. to attach a new behavior to it.
+A cell does not draw a random number every time step to decide whether it
+moves: it draws the time step of its next move (see 'NextMigrationStep'),
+and 'Run' returns right away until then. A cell that never moves (a
+propability of 0, as in example "ex11") drops this behavior in its first
+time step.
+*/
+template <typename TAgent = Cell, BoundaryMode kBoundary = BoundaryMode::kNone,
+          typename TOnStick = NoStickAction>
+class CellMigration : public Behavior {
+  BDM_BEHAVIOR_HEADER(CellMigration, Behavior, 1);
+
+  public:
+    CellMigration() { AlwaysCopyToNew(); }
+    CellMigration(real_t migration_rate, real_t propability,
+                  const TOnStick& on_stick = TOnStick())
+      : migration_rate_(migration_rate), propability_(propability), on_stick_(on_stick) {}
+
+    virtual ~CellMigration() = default;
+
+    void Initialize(const NewAgentEvent& event) override {
+      // https://biodynamo.github.io/api/structbdm_1_1NewAgentEvent.html
+      Base::Initialize(event);
+
+      // if cell divides then behavior attributes have to be initialized
+      if (auto* b = dynamic_cast<CellMigration*>(event.existing_behavior)) {
+        migration_rate_ = b->GetMigrationRate();
+        propability_ = b->GetPropability();
+        on_stick_ = b->on_stick_;
+      } else {
+        Log::Fatal("CellMigration::Initialize",
+                   "event.existing_behavior was not of type CellMigration");
+      }
+    }
+
+    void Run(Agent* agent) override {
+      // look up the simulation engine only once per call
+      auto* sim = Simulation::GetActive();
+      const uint64_t step = CounterRandom::GetStep(sim);
+      // the cell sleeps until the time step of its next move (drawn by
+      // this very cell, not by the one this behavior was copied from)
+      const bool scheduled = (scheduled_uid_ == agent->GetUid());
+      if (scheduled && step < next_step_) return;
+
+      // the agent type is known at compile time, hence checked only
+      // in debug builds
+      auto* cell = bdm_static_cast<TAgent*>(agent);
+      const auto* param = sim->GetParam();
+      if (!scheduled) {
+        if (propability_ <= 0.0) {
+          // the cell never migrates
+          cell->RemoveBehavior(this);
+          return;
+        }
+        scheduled_uid_ = agent->GetUid();
+        next_step_ = NextMigrationStep(param->random_seed, agent->GetUid(), step, propability_);
+        if (step < next_step_) return;
+      }
+      // the random numbers of this cell at this time step do not depend
+      // on the number of threads (check the 'counter_random.h' header file)
+      CounterRandom rand(param->random_seed, agent->GetUid(), step, kMigrationStream);
+      next_step_ = NextMigrationStep(param->random_seed, agent->GetUid(), step + 1, propability_);
+
+      // calculate the cell (random) displacement after
+      // multiplying the velocity with the simulation
+      // time increment (time-step)
+      const real_t delta = migration_rate_ * param->simulation_time_step;
+      const Real3 displacement = rand.UniformArray<3>(-delta, +delta);
+
+      if constexpr (kBoundary == BoundaryMode::kNone) {
+        // update the spatial location of the cell
+        cell->UpdatePosition(displacement);
+      } else {
+        Real3 xyz = cell->GetPosition() + displacement;
+        const real_t min_b = param->min_bound + 0.55 * cell->GetDiameter();
+        const real_t max_b = param->max_bound - 0.55 * cell->GetDiameter();
+        // project the cell within the simulation domain boundaries (and
+        // some "margins" as indicated right above) without branching
+        bool cell_on_bound = false;
+        for (int i = 0; i < 3; ++i) {
+          const real_t clamped = std::clamp(xyz[i], min_b, max_b);
+          cell_on_bound |= (clamped != xyz[i]);
+          xyz[i] = clamped;
+        }
+        // https://biodynamo.github.io/api/classbdm_1_1Cell.html
+        cell->SetPosition(xyz);
+
+        if constexpr (kBoundary == BoundaryMode::kStick) {
+          if (cell_on_bound) {
+            // the behavior is deleted once removed from the cell,
+            // hence keep a copy of the action to perform afterwards
+            TOnStick on_stick = on_stick_;
+            // simply freeze the cell on the boundary and never
+            // let it migrate again
+            cell->RemoveBehavior(this);
+            on_stick(cell);
+          }
+        }
+      }
+    }
+
+    real_t GetMigrationRate() const { return migration_rate_; }
+    real_t GetPropability() const { return propability_; }
+    static constexpr bool GetStickToBoundary() {
+      return kBoundary == BoundaryMode::kStick;
+    }
+
+  private:
+    real_t migration_rate_ = 1.0;
+    real_t propability_ = 1.000;
+    TOnStick on_stick_;
+    // the time step of the next move, and the cell that drew it
+    AgentUid scheduled_uid_;
+    uint64_t next_step_ = 0;
+};
+
+} // namespace bdm
+
+#endif // CELL_MIGRATION_H_
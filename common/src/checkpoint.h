@@ -0,0 +1,397 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "biodynamo.h"
+#include "counter_random.h"
+#include "substances.h"
+
+namespace bdm {
+
+// parameters of a behavior stored in a checkpoint
+using CheckpointParams = std::array<real_t, 4>;
+
+/*
+Binary checkpoint of the state of a simulation of cells: the position,
+diameter, density and an integer "kind" (e.g. the phenotype) of every cell,
+the parameters of their behaviors, the concentrations of all substances,
+the time step and the random seed. The random numbers of the behaviors in
+this folder are keyed on the seed, the time step and the uid of the agent
+(see the 'counter_random.h' header file), and 'Load' adds the cells anew,
+i.e., with new uids: a restarted simulation is statistically equivalent to
+the uninterrupted one, but it does not draw the same random numbers.
+The file is a header followed by plain arrays of fixed-size records, which
+are written to a temporary file renamed over the previous checkpoint (thus
+an interrupted write never corrupts it) and read back through a memory map.
+Only the behaviors registered with 'RegisterBehavior' can be checkpointed;
+the rest of the state (e.g. standalone operations) is rebuilt by the
+example as usual.
+Usage:
+  auto* checkpoint = new Checkpoint();
+  checkpoint->RegisterBehavior<MyMigration>("migration",
+      [](const MyMigration& b, const Agent&) { return CheckpointParams{...}; },
+      [](const CheckpointParams& p) { return new MyMigration(p[0], p[1]); });
+  if (restart) {
+    checkpoint->Load("checkpoint.bin");
+  } else {
+    ModelInitializer::...
+  }
+  checkpoint->Install(sim.GetScheduler(), "checkpoint.bin", 100);
+*/
+class Checkpoint : public StandaloneOperationImpl {
+  BDM_OP_HEADER(Checkpoint);
+
+  public:
+    // maps a cell to its kind (e.g. its phenotype)
+    using Kind = std::function<int(const Agent*)>;
+    // creates a new cell of the given kind
+    using NewCell = std::function<Cell*(int)>;
+
+    struct Header {
+      char magic[8];
+      uint32_t version;
+      uint32_t num_types;
+      uint64_t step;
+      uint64_t seed;
+      uint64_t num_agents;
+      uint64_t num_behaviors;
+      uint64_t num_grids;
+    };
+
+    Checkpoint() = default;
+
+    // defines how cells are mapped to and created from their kind
+    void SetKind(const Kind& kind, const NewCell& new_cell) {
+      kind_ = kind;
+      new_cell_ = new_cell;
+    }
+
+    /*
+    Registers a behavior type under a (unique) name, with the functions that
+    extract its parameters and create it again from these.
+    */
+    template <typename TBehavior>
+    void RegisterBehavior(
+        const std::string& name,
+        const std::function<CheckpointParams(const TBehavior&, const Agent&)>& save,
+        const std::function<Behavior*(const CheckpointParams&)>& restore) {
+      if (name.size() >= sizeof(TypeRecord::name)) {
+        Log::Fatal("Checkpoint::RegisterBehavior", "name too long: ", name);
+      }
+      codecs_.push_back({name, &typeid(TBehavior),
+                         [save](const Behavior* behavior, const Agent& agent) {
+                           return save(*static_cast<const TBehavior*>(behavior), agent);
+                         },
+                         restore});
+    }
+
+    // writes a checkpoint every given number of time steps to the file
+    void Install(Scheduler* scheduler, const std::string& file, uint64_t interval) {
+      file_ = file;
+      interval_ = std::max<uint64_t>(interval, 1);
+      auto* op = new Operation("checkpoint");
+      op->AddOperationImpl(kCpu, this);
+      scheduler->ScheduleOp(op, OpType::kPostSchedule);
+    }
+
+    void operator()() override {
+      const uint64_t step = CounterRandom::GetStep(Simulation::GetActive()) + 1;
+      if (step % interval_ == 0) Save(file_, step);
+    }
+
+    // writes the state of the active simulation after the given time step
+    void Save(const std::string& file, uint64_t step) const {
+      auto* sim = Simulation::GetActive();
+      auto* rm = sim->GetResourceManager();
+
+      std::vector<AgentRecord> agents;
+      std::vector<BehaviorRecord> behaviors;
+      agents.reserve(rm->GetNumAgents());
+      // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
+      rm->ForEachAgent([&](Agent* agent) {
+        const auto* cell = bdm_static_cast<const Cell*>(agent);
+        AgentRecord record;
+        for (int d = 0; d < 3; ++d) record.position[d] = cell->GetPosition()[d];
+        record.diameter = cell->GetDiameter();
+        record.density = cell->GetDensity();
+        record.kind = kind_ ? kind_(agent) : 0;
+        record.num_behaviors = 0;
+        for (const auto* behavior : agent->GetAllBehaviors()) {
+          const uint32_t type = FindCodec(typeid(*behavior));
+          BehaviorRecord b = {type, 0, {}};
+          const CheckpointParams params = codecs_[type].save(behavior, *agent);
+          std::copy(params.begin(), params.end(), b.params);
+          behaviors.push_back(b);
+          ++record.num_behaviors;
+        }
+        agents.push_back(record);
+      });
+
+      std::vector<GridRecord> grids;
+      std::vector<const real_t*> concentrations;
+      rm->ForEachDiffusionGrid([&](DiffusionGrid* grid) {
+        GridRecord record = {};
+        std::strncpy(record.name, grid->GetSubstanceName().c_str(), sizeof(record.name) - 1);
+        record.num_boxes = grid->GetNumBoxes();
+        record.resolution = grid->GetResolution();
+        for (int d = 0; d < 3; ++d) record.lower[d] = grid->GetDimensions()[2 * d];
+        record.box_length = grid->GetBoxLength();
+        grids.push_back(record);
+        SynchronizeConcentration(grid);
+        concentrations.push_back(grid->GetAllConcentrations());
+      });
+
+      Header header = {};
+      std::memcpy(header.magic, kMagic, sizeof(header.magic));
+      header.version = kVersion;
+      header.num_types = codecs_.size();
+      header.step = step;
+      header.seed = sim->GetParam()->random_seed;
+      header.num_agents = agents.size();
+      header.num_behaviors = behaviors.size();
+      header.num_grids = grids.size();
+
+      const std::string tmp = file + ".tmp";
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      Write(&out, &header, 1);
+      for (const auto& codec : codecs_) {
+        TypeRecord type = {};
+        std::strncpy(type.name, codec.name.c_str(), sizeof(type.name) - 1);
+        Write(&out, &type, 1);
+      }
+      Write(&out, agents.data(), agents.size());
+      Write(&out, behaviors.data(), behaviors.size());
+      for (size_t g = 0; g < grids.size(); ++g) {
+        Write(&out, &grids[g], 1);
+        std::vector<double> values(concentrations[g], concentrations[g] + grids[g].num_boxes);
+        Write(&out, values.data(), values.size());
+      }
+      out.close();
+      if (!out || std::rename(tmp.c_str(), file.c_str()) != 0) {
+        Log::Fatal("Checkpoint::Save", "could not write the checkpoint ", file);
+      }
+    }
+
+    // reads only the header of a checkpoint (e.g. before the simulation starts)
+    static Header ReadHeader(const std::string& file) {
+      Header header = {};
+      std::ifstream in(file, std::ios::binary);
+      in.read(reinterpret_cast<char*>(&header), sizeof(header));
+      if (!in) {
+        Log::Fatal("Checkpoint::ReadHeader", "could not read the checkpoint ", file);
+      }
+      CheckHeader(header, file);
+      return header;
+    }
+
+    /*
+    Adds the cells of the checkpoint to the active simulation and sets the
+    initial concentrations of its substances (which have to be defined
+    beforehand, with the same resolution); returns the time step of the
+    checkpoint.
+    */
+    uint64_t Load(const std::string& file) const {
+      MappedFile map(file);
+      const Header header = *map.Next<Header>(1);
+      CheckHeader(header, file);
+      // the behavior types of the file, in terms of the registered ones
+      const TypeRecord* types = map.Next<TypeRecord>(header.num_types);
+      std::vector<uint32_t> codec(header.num_types);
+      for (uint32_t t = 0; t < header.num_types; ++t) {
+        codec[t] = FindCodec(types[t].name);
+      }
+      const AgentRecord* agents = map.Next<AgentRecord>(header.num_agents);
+      const BehaviorRecord* behaviors = map.Next<BehaviorRecord>(header.num_behaviors);
+
+      auto* rm = Simulation::GetActive()->GetResourceManager();
+      const BehaviorRecord* b = behaviors;
+      for (uint64_t i = 0; i < header.num_agents; ++i) {
+        const AgentRecord& record = agents[i];
+        if (static_cast<uint64_t>(b - behaviors) + record.num_behaviors > header.num_behaviors) {
+          Log::Fatal("Checkpoint::Load", "corrupt checkpoint ", file);
+        }
+        Cell* cell = new_cell_ ? new_cell_(record.kind) : new Cell();
+        cell->SetPosition({record.position[0], record.position[1], record.position[2]});
+        cell->SetDiameter(record.diameter);
+        cell->SetDensity(record.density);
+        for (uint32_t j = 0; j < record.num_behaviors; ++j, ++b) {
+          if (b->type >= header.num_types) {
+            Log::Fatal("Checkpoint::Load", "corrupt checkpoint ", file);
+          }
+          CheckpointParams params;
+          std::copy(b->params, b->params + params.size(), params.begin());
+          cell->AddBehavior(codecs_[codec[b->type]].restore(params));
+        }
+        rm->AddAgent(cell);
+      }
+
+      for (uint64_t g = 0; g < header.num_grids; ++g) {
+        const GridRecord& record = *map.Next<GridRecord>(1);
+        const double* values = map.Next<double>(record.num_boxes);
+        auto* grid = rm->GetDiffusionGrid(record.name);
+        if (grid == nullptr || grid->GetResolution() != static_cast<size_t>(record.resolution)) {
+          Log::Fatal("Checkpoint::Load", "substance ", record.name,
+                     " not defined or of different resolution");
+        }
+        // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
+        ModelInitializer::InitializeSubstance(
+            grid->GetSubstanceId(),
+            [record, c = std::make_shared<std::vector<real_t>>(values, values + record.num_boxes)](
+                real_t x, real_t y, real_t z) {
+              // the initializer is evaluated at the lower corner of every box
+              const real_t xyz[3] = {x, y, z};
+              size_t index = 0;
+              for (int d = 2; d >= 0; --d) {
+                const long i = std::lround((xyz[d] - record.lower[d]) / record.box_length);
+                index = index * record.resolution +
+                        std::clamp<long>(i, 0, record.resolution - 1);
+              }
+              return (*c)[index];
+            });
+      }
+      return header.step;
+    }
+
+  private:
+    static constexpr char kMagic[8] = {'B', 'D', 'M', 'C', 'K', 'P', 'T', '\0'};
+    static constexpr uint32_t kVersion = 1;
+
+    struct TypeRecord {
+      char name[56];
+    };
+    struct AgentRecord {
+      double position[3];
+      double diameter;
+      double density;
+      int32_t kind;
+      uint32_t num_behaviors;
+    };
+    struct BehaviorRecord {
+      uint32_t type;
+      uint32_t padding;
+      double params[4];
+    };
+    struct GridRecord {
+      char name[56];
+      uint64_t num_boxes;
+      int64_t resolution;
+      double lower[3];
+      double box_length;
+    };
+
+    struct Codec {
+      std::string name;
+      const std::type_info* type;
+      std::function<CheckpointParams(const Behavior*, const Agent&)> save;
+      std::function<Behavior*(const CheckpointParams&)> restore;
+    };
+
+    /*
+    Read-only memory map of a whole file, read front to back as arrays of
+    records (all of them multiples of 8 bytes long, hence aligned).
+    */
+    struct MappedFile {
+      explicit MappedFile(const std::string& file) : file(file) {
+        const int fd = open(file.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+          Log::Fatal("Checkpoint::Load", "could not open the checkpoint ", file);
+        }
+        size = st.st_size;
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+          Log::Fatal("Checkpoint::Load", "could not map the checkpoint ", file);
+        }
+        // the records are read once, front to back
+        madvise(addr, size, MADV_SEQUENTIAL | MADV_WILLNEED);
+        data = static_cast<const char*>(addr);
+      }
+      ~MappedFile() { munmap(const_cast<char*>(data), size); }
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+
+      // the next 'count' records of the file
+      template <typename T>
+      const T* Next(uint64_t count) {
+        if ((size - offset) / sizeof(T) < count) {
+          Log::Fatal("Checkpoint::Load", "truncated checkpoint ", file);
+        }
+        const T* ret = reinterpret_cast<const T*>(data + offset);
+        offset += count * sizeof(T);
+        return ret;
+      }
+
+      std::string file;
+      const char* data = nullptr;
+      size_t size = 0;
+      size_t offset = 0;
+    };
+
+    static void CheckHeader(const Header& header, const std::string& file) {
+      if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+          header.version != kVersion) {
+        Log::Fatal("Checkpoint", file, " is not a checkpoint (of version ", kVersion, ")");
+      }
+    }
+
+    template <typename T>
+    static void Write(std::ofstream* out, const T* data, size_t count) {
+      out->write(reinterpret_cast<const char*>(data), count * sizeof(T));
+    }
+
+    uint32_t FindCodec(const std::type_info& type) const {
+      for (uint32_t c = 0; c < codecs_.size(); ++c) {
+        if (*codecs_[c].type == type) return c;
+      }
+      Log::Fatal("Checkpoint::Save", "behavior not registered: ", type.name());
+      return 0;
+    }
+    uint32_t FindCodec(const std::string& name) const {
+      for (uint32_t c = 0; c < codecs_.size(); ++c) {
+        if (codecs_[c].name == name) return c;
+      }
+      Log::Fatal("Checkpoint::Load", "behavior not registered: ", name);
+      return 0;
+    }
+
+    std::string file_;
+    uint64_t interval_ = 1;
+    Kind kind_;
+    NewCell new_cell_;
+    std::vector<Codec> codecs_;
+};
+
+} // namespace bdm
+
+#endif // CHECKPOINT_H_
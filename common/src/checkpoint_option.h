@@ -0,0 +1,96 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef CHECKPOINT_OPTION_H_
+#define CHECKPOINT_OPTION_H_
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "biodynamo.h"
+#include "checkpoint.h"
+#include "counter_random.h"
+#include "scenario.h"
+
+namespace bdm {
+
+/*
+Option of the scenario (see the 'scenario.h' header file) that checkpoints
+the simulation (see the 'checkpoint.h' header file):
+  --checkpoint writes the state of the simulation to 'checkpoint.bin' in
+             the output folder every given number of steps
+  --restart  resumes the simulation from the given checkpoint, i.e., it
+             simulates the remaining steps only, with the same random seed;
+             the restored cells get new uids, hence the random numbers and
+             the result are statistically equivalent to those of the
+             uninterrupted run, not identical
+The example registers the behaviors of its cells with 'GetCheckpoint', and
+creates its cells only if 'Restart' did not add those of the checkpoint.
+*/
+class CheckpointOption : public ScenarioOption {
+  public:
+    explicit CheckpointOption(CommandLineOptions* clo) {
+      clo->AddOption<uint64_t>("checkpoint", "0", "Write a checkpoint every given steps (0 disables)");
+      clo->AddOption<std::string>("restart", "", "Checkpoint file to resume the simulation from");
+    }
+
+    void Apply(const Scenario&, CommandLineOptions* clo, Param* param) override {
+      interval_ = clo->Get<uint64_t>("checkpoint");
+      restart_file_ = clo->Get<std::string>("restart");
+      if (IsRestarted()) {
+        restart_ = Checkpoint::ReadHeader(restart_file_);
+        param->random_seed = restart_.seed;
+      }
+    }
+
+    void Install(const Scenario&, Simulation* sim, uint64_t* steps) override {
+      // continue the time steps of the checkpoint, hence the random
+      // numbers keyed on them (see the 'counter_random.h' header file)
+      const uint64_t first_step = IsRestarted() ? std::min(restart_.step, *steps) : 0;
+      CounterRandom::SetStepOffset(first_step);
+      *steps -= first_step;
+      if (interval_ > 0) {
+        // the scheduler takes over the checkpoint operation
+        checkpoint_.release()->Install(sim->GetScheduler(),
+                                       sim->GetOutputDir() + "/checkpoint.bin", interval_);
+      }
+    }
+
+    // the checkpoint, where the example registers the behaviors of its cells
+    Checkpoint* GetCheckpoint() const { return checkpoint_.get(); }
+
+    /*
+    Adds the cells (and the substance concentrations) of the checkpoint to
+    the simulation if restarted, in which case the example does not create
+    them itself; returns whether restarted.
+    */
+    bool Restart() const {
+      if (!IsRestarted()) return false;
+      checkpoint_->Load(restart_file_);
+      return true;
+    }
+
+    bool IsCheckpointed() const { return interval_ > 0 || IsRestarted(); }
+    bool IsRestarted() const { return !restart_file_.empty(); }
+
+  private:
+    uint64_t interval_ = 0;
+    std::string restart_file_;
+    Checkpoint::Header restart_ = {};
+    std::unique_ptr<Checkpoint> checkpoint_ = std::make_unique<Checkpoint>();
+};
+
+} // namespace bdm
+
+#endif // CHECKPOINT_OPTION_H_
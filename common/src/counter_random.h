@@ -0,0 +1,203 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef COUNTER_RANDOM_H_
+#define COUNTER_RANDOM_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+Philox-4x32-10 block function (Salmon et al., "Parallel random numbers: as
+easy as 1, 2, 3", SC 2011): it maps a 128-bit counter and a 64-bit key to
+128 random bits, with no state other than its arguments.
+*/
+inline std::array<uint32_t, 4> Philox4x32(std::array<uint32_t, 4> ctr,
+                                          std::array<uint32_t, 2> key) {
+  constexpr uint64_t kM0 = 0xD2511F53, kM1 = 0xCD9E8D57;
+  constexpr uint32_t kW0 = 0x9E3779B9, kW1 = 0xBB67AE85;
+  for (int round = 0; round < 10; ++round) {
+    const uint64_t p0 = kM0 * ctr[0];
+    const uint64_t p1 = kM1 * ctr[2];
+    ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(p1),
+           static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(p0)};
+    key[0] += kW0;
+    key[1] += kW1;
+  }
+  return ctr;
+}
+
+/*
+Identifiers of the random streams of the behaviors in this folder, so that
+two behaviors of the same agent never draw the same numbers.
+*/
+enum RandomStream : uint32_t {
+  kMigrationStream = 1,
+  kDivisionStream = 2,
+  kDivisionTimeStream = 3,
+  kMigrationTimeStream = 4
+};
+
+/*
+Counter-based random number generator: the n-th number drawn is a function
+of (seed, agent uid, time step, stream, n) only. Hence, unlike the shared
+'Simulation::GetActive()->GetRandom()', it needs neither state shared among
+threads nor locks, and an agent draws the very same numbers no matter the
+number of threads or the order in which agents are processed.
+Usage (in the 'Run' method of a behavior):
+  auto rand = CounterRandom::ForAgent(agent, kMigrationStream);
+  if (rand.Uniform() > propability_) return;
+  ...
+*/
+class CounterRandom {
+  public:
+    CounterRandom(uint64_t seed, const AgentUid& uid, uint64_t step, uint32_t stream)
+      : key_{static_cast<uint32_t>(seed),
+             static_cast<uint32_t>(seed >> 32) ^ (stream * 0x85EBCA6Bu)},
+        ctr_{0, static_cast<uint32_t>(step), uid.GetIndex(),
+             uid.GetReused() ^ (static_cast<uint32_t>(step >> 32) << 16)} {}
+
+    // the stream of an agent at the current time step of the simulation
+    static CounterRandom ForAgent(const Agent* agent, uint32_t stream) {
+      auto* sim = Simulation::GetActive();
+      return CounterRandom(sim->GetParam()->random_seed, agent->GetUid(),
+                           GetStep(sim), stream);
+    }
+
+    /*
+    Current time step of the simulation, which after a restart continues
+    from the step of the checkpoint (see the 'checkpoint.h' header file).
+    */
+    static uint64_t GetStep(Simulation* sim) {
+      return step_offset_ + sim->GetScheduler()->GetSimulatedSteps();
+    }
+    static void SetStepOffset(uint64_t step_offset) { step_offset_ = step_offset; }
+
+    // uniform random number in [0, max)
+    real_t Uniform(real_t max = 1.0) { return max * Next(); }
+    // uniform random number in [min, max)
+    real_t Uniform(real_t min, real_t max) { return min + (max - min) * Next(); }
+    // array of uniform random numbers in [min, max)
+    template <uint64_t N>
+    MathArray<real_t, N> UniformArray(real_t min, real_t max) {
+      MathArray<real_t, N> ret;
+      for (uint64_t i = 0; i < N; ++i) ret[i] = Uniform(min, max);
+      return ret;
+    }
+
+    // number of random numbers drawn so far
+    uint32_t GetDrawIndex() const { return draw_; }
+
+  private:
+    // uniform random number in [0, 1) with 53 random bits; every block of
+    // the generator gives two of them
+    double Next() {
+      if (draw_ % 2 == 0) {
+        ctr_[0] = draw_ / 2;
+        block_ = Philox4x32(ctr_, key_);
+      }
+      const uint32_t* bits = block_.data() + 2 * (draw_++ % 2);
+      return ((bits[0] >> 5) * 67108864.0 + (bits[1] >> 6)) / 9007199254740992.0;
+    }
+
+    // time steps simulated before the restart of the simulation
+    inline static uint64_t step_offset_ = 0;
+
+    std::array<uint32_t, 2> key_;
+    std::array<uint32_t, 4> ctr_;
+    std::array<uint32_t, 4> block_ = {};
+    uint32_t draw_ = 0;
+};
+
+/*
+The first k uniform random numbers of the streams of n agents at a time
+step, in bulk: u[i * k + j] is, bit for bit, the j-th number drawn by
+'CounterRandom(seed, uids[i], step, stream)'. Instead of one Philox block
+per call of 'Uniform', the blocks of (up to) 64 agents are computed at once
+over arrays of their counters, in a loop the compiler vectorizes (the
+products of 32-bit words are vector multiplies); every thread works on its
+own chunks of agents with buffers on its stack.
+*/
+inline void CounterUniforms(uint64_t seed, const AgentUid* uids, size_t n, uint64_t step,
+                            uint32_t stream, size_t k, real_t* u) {
+  constexpr size_t kLanes = 64;
+  constexpr uint64_t kM0 = 0xD2511F53, kM1 = 0xCD9E8D57;
+  constexpr uint32_t kW0 = 0x9E3779B9, kW1 = 0xBB67AE85;
+  const uint32_t key0 = static_cast<uint32_t>(seed);
+  const uint32_t key1 = static_cast<uint32_t>(seed >> 32) ^ (stream * 0x85EBCA6Bu);
+  const uint32_t step_lo = static_cast<uint32_t>(step);
+  const uint32_t step_hi = static_cast<uint32_t>(step >> 32) << 16;
+  const size_t num_chunks = (n + kLanes - 1) / kLanes;
+#pragma omp parallel for schedule(static)
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    const size_t first = chunk * kLanes;
+    const size_t lanes = std::min(kLanes, n - first);
+    uint32_t index[kLanes], reused[kLanes];
+    uint32_t x0[kLanes], x1[kLanes], x2[kLanes], x3[kLanes];
+    for (size_t l = 0; l < lanes; ++l) {
+      index[l] = uids[first + l].GetIndex();
+      reused[l] = uids[first + l].GetReused() ^ step_hi;
+    }
+    // every block gives two numbers (see 'CounterRandom::Next')
+    for (size_t block = 0; block < (k + 1) / 2; ++block) {
+#pragma omp simd
+      for (size_t l = 0; l < lanes; ++l) {
+        uint32_t c0 = static_cast<uint32_t>(block), c1 = step_lo, c2 = index[l], c3 = reused[l];
+        uint32_t k0 = key0, k1 = key1;
+        for (int round = 0; round < 10; ++round) {
+          const uint64_t p0 = kM0 * c0;
+          const uint64_t p1 = kM1 * c2;
+          c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+          c1 = static_cast<uint32_t>(p1);
+          c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+          c3 = static_cast<uint32_t>(p0);
+          k0 += kW0;
+          k1 += kW1;
+        }
+        x0[l] = c0;
+        x1[l] = c1;
+        x2[l] = c2;
+        x3[l] = c3;
+      }
+      const size_t j = 2 * block;
+      for (size_t l = 0; l < lanes; ++l) {
+        real_t* v = u + (first + l) * k;
+        v[j] = ((x0[l] >> 5) * 67108864.0 + (x1[l] >> 6)) / 9007199254740992.0;
+        if (j + 1 < k) v[j + 1] = ((x2[l] >> 5) * 67108864.0 + (x3[l] >> 6)) / 9007199254740992.0;
+      }
+    }
+  }
+}
+
+/*
+Number of time steps (at least 1) until the first success of a Bernoulli
+trial of the given propability per time step, i.e., the geometric
+distribution, sampled by inversion from a single uniform random number u.
+*/
+inline uint64_t GeometricSteps(real_t propability, real_t u) {
+  if (propability >= 1.0) return 1;
+  if (propability <= 0.0) return std::numeric_limits<uint64_t>::max();
+  const real_t k = std::floor(std::log1p(-u) / std::log1p(-propability));
+  return k < 1e18 ? static_cast<uint64_t>(k) + 1 : std::numeric_limits<uint64_t>::max();
+}
+
+} // namespace bdm
+
+#endif // COUNTER_RANDOM_H_
@@ -0,0 +1,63 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef DECAY_GRID_H_
+#define DECAY_GRID_H_
+
+#include <cmath>
+#include <string>
+
+#include "biodynamo.h"
+#include "dirichlet_boundary.h"
+
+namespace bdm {
+
+/*
+Lattice of a substance that does not diffuse (zero diffusion coefficient),
+hence its voxels are not coupled: every time step each voxel decays on its
+own, by the exact factor exp(-decay_constant * dt) rather than the explicit
+Euler factor (1 - decay_constant * dt), which is unconditionally stable for
+any time step. The secretion of the agents accumulates in the voxels as for
+any other lattice. The boundary conditions make no difference, except for
+Dirichlet ones that fix the concentration of the boundary voxels.
+*/
+class DecayGrid : public DiffusionGrid {
+  public:
+    DecayGrid() = default;
+    DecayGrid(int substance_id, const std::string& substance_name, real_t decay_constant,
+              int resolution = 10)
+      : DiffusionGrid(substance_id, substance_name, 0.0, decay_constant, resolution) {}
+
+    void DiffuseWithClosedEdge(real_t dt) override { Decay(dt); }
+    void DiffuseWithOpenEdge(real_t dt) override { Decay(dt); }
+    void DiffuseWithNeumann(real_t dt) override { Decay(dt); }
+    void DiffuseWithPeriodic(real_t dt) override { Decay(dt); }
+    void DiffuseWithDirichlet(real_t dt) override {
+      Decay(dt);
+      SetDirichletBoundary(*this, GetSimulatedTime(), &c1_);
+    }
+
+  private:
+    void Decay(real_t dt) {
+      const real_t factor = std::exp(-mu_ * dt);
+      const size_t n = total_num_boxes_;
+#pragma omp parallel for simd schedule(static)
+      for (size_t i = 0; i < n; ++i) c1_[i] *= factor;
+    }
+
+    BDM_CLASS_DEF_OVERRIDE(DecayGrid, 1);
+};
+
+} // namespace bdm
+
+#endif // DECAY_GRID_H_
@@ -0,0 +1,86 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef DIRICHLET_BOUNDARY_H_
+#define DIRICHLET_BOUNDARY_H_
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+Sets the concentrations 'c' of the voxels on the faces of a lattice of n^3
+voxels to a constant value, in bulk: the bottom and top planes, and the
+first and last row and the two ends of every other row of the planes in
+between, by loops over contiguous voxels where possible (vectorized).
+*/
+template <typename TArray>
+inline void FillBoundaryFaces(size_t n, real_t value, TArray* c) {
+  const size_t nn = n * n;
+  const size_t last = (n - 1) * nn;
+#pragma omp parallel for simd schedule(static)
+  for (size_t i = 0; i < nn; ++i) {
+    (*c)[i] = value;
+    (*c)[last + i] = value;
+  }
+#pragma omp parallel for schedule(static)
+  for (size_t z = 1; z < n - 1; ++z) {
+    const size_t plane = nn * z;
+#pragma omp simd
+    for (size_t x = 0; x < n; ++x) {
+      (*c)[plane + x] = value;
+      (*c)[plane + nn - n + x] = value;
+    }
+    for (size_t y = 1; y < n - 1; ++y) {
+      (*c)[plane + n * y] = value;
+      (*c)[plane + n * y + n - 1] = value;
+    }
+  }
+}
+
+/*
+Sets the concentrations 'c' of the voxels on the faces of the lattice of a
+substance to the values of its (Dirichlet) boundary condition at the given
+time, as the finite difference solver of the simulation engine does. A
+constant boundary condition (e.g. 'ConstantBoundaryCondition(0)') is
+evaluated once and its value filled in bulk, instead of being evaluated
+(a virtual call) for every voxel of the faces.
+*/
+template <typename TArray>
+inline void SetDirichletBoundary(const DiffusionGrid& grid, real_t time, TArray* c) {
+  // https://biodynamo.github.io/api/classbdm_1_1DiffusionGrid.html
+  const auto* bc = grid.GetBoundaryCondition();
+  const size_t n = grid.GetResolution();
+  // https://biodynamo.github.io/api/classbdm_1_1ConstantBoundaryCondition.html
+  if (dynamic_cast<const ConstantBoundaryCondition*>(bc) != nullptr) {
+    FillBoundaryFaces(n, bc->Evaluate(0.0, 0.0, 0.0, time), c);
+    return;
+  }
+  const auto dims = grid.GetDimensions();
+  const real_t h = grid.GetBoxLength();
+#pragma omp parallel for collapse(2)
+  for (size_t z = 0; z < n; ++z) {
+    for (size_t y = 0; y < n; ++y) {
+      const bool face = (z == 0 || z == n - 1 || y == 0 || y == n - 1);
+      // every voxel of a face of the lattice, or the two ends of the row
+      for (size_t x = 0; x < n; x += (face || x == n - 1) ? 1 : n - 1) {
+        (*c)[x + n * (y + n * z)] =
+            bc->Evaluate(dims[0] + x * h, dims[2] + y * h, dims[4] + z * h, time);
+      }
+    }
+  }
+}
+
+} // namespace bdm
+
+#endif // DIRICHLET_BOUNDARY_H_
@@ -0,0 +1,108 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef DORMANT_TIER_H_
+#define DORMANT_TIER_H_
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+Tier of dormant agents, i.e., agents that are frozen for the rest of the
+simulation. A dormant agent stays in the simulation, hence it is still
+found by neighbor queries (and it still pushes the agents around it) and it
+is still exported for visualization, but the agent operations (its
+behaviors and its mechanical forces) are no longer executed for it, as long
+as the scheduler filters the agents with 'IsActive'.
+Agents are frozen from within behaviors (possibly in parallel) and they
+become dormant at the end of the time step, when this (post-scheduled)
+operation runs.
+Usage:
+  auto* dormant = new DormantTier();
+  auto* op = new Operation("dormant tier");
+  op->AddOperationImpl(kCpu, dormant);
+  sim.GetScheduler()->ScheduleOp(op, OpType::kPostSchedule);
+  auto active = L2F([dormant](Agent* agent) { return dormant->IsActive(agent); });
+  sim.GetScheduler()->SetAgentFilters({&active});
+  ...
+  dormant->Freeze(cell);
+*/
+class DormantTier : public StandaloneOperationImpl {
+  BDM_OP_HEADER(DormantTier);
+
+  public:
+    DormantTier() : frozen_(ThreadInfo::GetInstance()->GetMaxThreads()) {}
+
+    // freeze the agent from the next time step on (thread-safe)
+    void Freeze(const Agent* agent) {
+      frozen_[ThreadInfo::GetInstance()->GetMyThreadId()].push_back(agent->GetUid());
+    }
+
+    bool IsDormant(const Agent* agent) const {
+      const AgentUid& uid = agent->GetUid();
+      return uid.GetIndex() < dormant_.size() &&
+             dormant_[uid.GetIndex()] == uid.GetReused();
+    }
+    bool IsActive(const Agent* agent) const { return !IsDormant(agent); }
+
+    uint64_t GetNumDormant() const { return num_dormant_; }
+
+    // move the agents frozen during this time step into the dormant tier
+    void operator()() override {
+      for (auto& frozen : frozen_) {
+        for (const AgentUid& uid : frozen) {
+          if (uid.GetIndex() >= dormant_.size()) {
+            dormant_.resize(uid.GetIndex() + 1, kActive);
+          }
+          if (dormant_[uid.GetIndex()] != uid.GetReused()) {
+            dormant_[uid.GetIndex()] = uid.GetReused();
+            ++num_dormant_;
+          }
+        }
+        frozen.clear();
+      }
+    }
+
+  private:
+    static constexpr AgentUid::Reused_t kActive =
+        std::numeric_limits<AgentUid::Reused_t>::max();
+
+    // the 'reused' counter of the dormant agent of every uid index (such
+    // that a reused uid of a removed dormant agent is not dormant), or
+    // kActive if there is none
+    std::vector<AgentUid::Reused_t> dormant_;
+    uint64_t num_dormant_ = 0;
+    // agents frozen during the current time step, per thread
+    std::vector<std::vector<AgentUid>> frozen_;
+};
+
+/*
+Action that freezes a cell (e.g. right after it sticks to the domain
+boundary, see the 'cell_migration.h' header file).
+*/
+struct FreezeAction {
+  DormantTier* dormant = nullptr;
+
+  void operator()(Agent* agent) const {
+    if (dormant != nullptr) dormant->Freeze(agent);
+  }
+};
+
+} // namespace bdm
+
+#endif // DORMANT_TIER_H_
@@ -0,0 +1,274 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef FUSED_SUBSTANCE_GRID_H_
+#define FUSED_SUBSTANCE_GRID_H_
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "biodynamo.h"
+#include "agent_voxels.h"
+#include "dirichlet_boundary.h"
+#include "stencil.h"
+#include "tiled_euler_grid.h"
+
+namespace bdm {
+
+class SubstanceGroup;
+
+/*
+Lattice of a substance that is solved together with all other substances of
+the same resolution, in a single sweep over one lattice that interleaves
+their concentrations voxel by voxel (see 'SubstanceGroup' below): the
+neighbors of a voxel are loaded once for all substances, each with its own
+diffusion coefficient and decay constant, instead of a sweep per substance.
+The first of the substances diffused by the simulation engine in a time
+step sweeps the group, the others find their time step done.
+The concentrations seen by the agents are still the lattice of every
+'DiffusionGrid', kept up to date as for the 'MixedPrecisionGrid' (see the
+'mixed_precision_grid.h' header file): at the voxels of the agents every
+time step, and on the whole lattice every 'sync_interval' time steps, every
+time step if the engine exports the visualization, and whenever
+'Synchronize' is called. The substances of a group need the same kind of
+boundary condition (Dirichlet boundaries may differ in their values).
+Selected with 'param->diffusion_method = "fused"' (see the 'substances.h'
+header file).
+*/
+class FusedSubstanceGrid : public DiffusionGrid {
+  public:
+    FusedSubstanceGrid() = default;
+    FusedSubstanceGrid(int substance_id, const std::string& substance_name,
+                       real_t diffusion_coeff, real_t decay_constant, int resolution = 10);
+    ~FusedSubstanceGrid() override;
+
+    void DiffuseWithClosedEdge(real_t dt) override { DiffuseGroup(dt); }
+    void DiffuseWithNeumann(real_t dt) override { DiffuseGroup(dt); }
+    void DiffuseWithOpenEdge(real_t dt) override { DiffuseGroup(dt); }
+    void DiffuseWithPeriodic(real_t dt) override { DiffuseGroup(dt); }
+    void DiffuseWithDirichlet(real_t dt) override { DiffuseGroup(dt); }
+
+    // brings the lattices of all substances of the group up to date
+    void Synchronize();
+
+    // number of substances swept together with this one (itself included)
+    size_t GetNumFused() const;
+
+  private:
+    friend class SubstanceGroup;
+
+    void DiffuseGroup(real_t dt);
+
+    // folds the change of voxel i since it was last synchronized (by the
+    // agents) into its interleaved concentration c, and copies it back
+    void Sync(size_t i, real_t* c) {
+      *c += c1_[i] - base_[i];
+      base_[i] = *c;
+      c1_[i] = *c;
+    }
+    void Load(size_t i, real_t* c) {
+      *c = c1_[i];
+      base_[i] = c1_[i];
+    }
+
+    real_t diffusion_coeff_ = 0.0;
+    uint64_t steps_ = 0;
+    // the value of every voxel when it was last synchronized
+    std::vector<real_t> base_;
+    std::shared_ptr<SubstanceGroup> group_;
+
+    BDM_CLASS_DEF_OVERRIDE(FusedSubstanceGrid, 1);
+};
+
+/*
+The substances of the same resolution (of a simulation) solved by a fused
+sweep: their concentrations are interleaved in one lattice of n^3 voxels
+times k substances, which is swept by the tiled kernel of the
+'tiled_euler_grid.h' header file row by row, every row of voxels being
+updated as one row of n * k values (see 'InterleavedEulerStencilRow').
+*/
+class SubstanceGroup {
+  public:
+    static std::shared_ptr<SubstanceGroup> Join(FusedSubstanceGrid* grid, int resolution) {
+      static std::map<std::pair<const Simulation*, int>, std::weak_ptr<SubstanceGroup>> groups;
+      auto& entry = groups[{Simulation::GetActive(), resolution}];
+      auto group = entry.lock();
+      if (group == nullptr) {
+        group = std::make_shared<SubstanceGroup>();
+        entry = group;
+      }
+      group->members_.push_back(grid);
+      // interleaved anew by the next time step
+      group->u_.clear();
+      return group;
+    }
+
+    void Leave(FusedSubstanceGrid* grid) {
+      members_.erase(std::remove(members_.begin(), members_.end(), grid), members_.end());
+      u_.clear();
+    }
+
+    // time step of the substance 'grid', i.e., of the whole group if not yet
+    void Step(FusedSubstanceGrid* grid, real_t dt) {
+      if (++grid->steps_ <= steps_) return;
+      steps_ = grid->steps_;
+      const size_t k = members_.size();
+      const size_t num_voxels = members_.front()->GetNumBoxes();
+      if (u_.size() != k * num_voxels) {
+        // (re)started: from the concentrations of the lattices
+        Reload();
+      }
+      // the secretion since the last time step, at the voxels of the agents
+      // then and now
+      voxels_.Update(*members_.front());
+      for (size_t i : voxels_.NowOrBefore()) SyncVoxel(i);
+
+      Sweep(dt);
+      for (size_t s = 0; s < k; ++s) {
+        auto* member = members_[s];
+        if (member->GetBoundaryConditionType() == BoundaryConditionType::kDirichlet) {
+          Component c = {u_.data() + s, k};
+          SetDirichletBoundary(*member, member->GetSimulatedTime(), &c);
+        }
+      }
+
+      const auto* param = Simulation::GetActive()->GetParam();
+      if (steps_ % sync_interval_ == 0 || param->export_visualization) {
+        Synchronize();
+      } else {
+        for (size_t i : voxels_.Now()) SyncVoxel(i);
+      }
+    }
+
+    void Synchronize() {
+      const size_t k = members_.size();
+      if (k == 0 || u_.size() != k * members_.front()->GetNumBoxes()) return;
+      const size_t num_voxels = u_.size() / k;
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < num_voxels; ++i) SyncVoxel(i);
+    }
+
+    size_t GetNumSubstances() const { return members_.size(); }
+
+  private:
+    // the values of one substance within the interleaved lattice
+    struct Component {
+      real_t* data;
+      size_t stride;
+      real_t& operator[](size_t i) { return data[i * stride]; }
+    };
+
+    void SyncVoxel(size_t i) {
+      const size_t k = members_.size();
+      for (size_t s = 0; s < k; ++s) members_[s]->Sync(i, &u_[i * k + s]);
+    }
+
+    void Reload() {
+      const size_t k = members_.size();
+      const size_t num_voxels = members_.front()->GetNumBoxes();
+      n_ = members_.front()->GetResolution();
+      u_.resize(k * num_voxels);
+      v_.resize(k * num_voxels);
+      zeros_.assign(k * n_, 0.0);
+      for (size_t s = 0; s < k; ++s) {
+        members_[s]->base_.resize(num_voxels);
+        for (size_t i = 0; i < num_voxels; ++i) members_[s]->Load(i, &u_[i * k + s]);
+      }
+      voxels_.Clear();
+    }
+
+    void Sweep(real_t dt) {
+      const size_t n = n_;
+      const size_t k = members_.size();
+      const size_t row_size = n * k;
+      auto edge_of = [](const FusedSubstanceGrid* member) {
+        const StencilEdge edge = GetStencilEdge(member->GetBoundaryConditionType());
+        // Dirichlet boundary voxels are reset after the sweep
+        return edge == StencilEdge::kFixed ? StencilEdge::kMirror : edge;
+      };
+      const StencilEdge edge = edge_of(members_.front());
+      r_.resize(row_size);
+      keep_.resize(row_size);
+      for (size_t s = 0; s < k; ++s) {
+        const auto* member = members_[s];
+        if (edge_of(member) != edge) {
+          Log::Fatal("SubstanceGroup::Sweep", "substance ", member->GetSubstanceName(),
+                     " differs in its kind of boundary condition from the substances of the",
+                     " same resolution");
+        }
+        const real_t h = member->GetBoxLength();
+        for (size_t x = 0; x < n; ++x) {
+          r_[x * k + s] = member->diffusion_coeff_ * dt / (h * h);
+          keep_[x * k + s] = 1.0 - member->GetDecayConstant() * dt;
+        }
+      }
+
+      const real_t* u = u_.data();
+      real_t* v = v_.data();
+      const real_t* zeros = zeros_.data();
+      const size_t plane = row_size * n;
+      const real_t* r = r_.data();
+      const real_t* keep = keep_.data();
+      WithStencilEdge(edge, [&](auto tag) {
+        constexpr StencilEdge kEdge = decltype(tag)::value;
+        TiledEulerGrid::ForEachTileRow(n, [&](size_t y, size_t z) {
+          const real_t* row = u + row_size * (y + n * z);
+          InterleavedEulerStencilRow<kEdge>(
+              n, k, r, keep, row, StencilNeighbor<kEdge>(row, y, false, row_size, n, zeros),
+              StencilNeighbor<kEdge>(row, y, true, row_size, n, zeros),
+              StencilNeighbor<kEdge>(row, z, false, plane, n, zeros),
+              StencilNeighbor<kEdge>(row, z, true, plane, n, zeros), v + row_size * (y + n * z));
+        });
+      });
+      u_.swap(v_);
+    }
+
+    std::vector<FusedSubstanceGrid*> members_;
+    size_t n_ = 0;
+    uint64_t steps_ = 0;
+    uint64_t sync_interval_ = 10;
+    // the interleaved lattice (and its next time step)
+    std::vector<real_t> u_, v_;
+    // coefficients of every value of a row, and a row of zeros
+    std::vector<real_t> r_, keep_, zeros_;
+    AgentVoxels voxels_;
+};
+
+inline FusedSubstanceGrid::FusedSubstanceGrid(int substance_id,
+                                              const std::string& substance_name,
+                                              real_t diffusion_coeff, real_t decay_constant,
+                                              int resolution)
+  : DiffusionGrid(substance_id, substance_name, diffusion_coeff, decay_constant, resolution),
+    diffusion_coeff_(diffusion_coeff), group_(SubstanceGroup::Join(this, resolution)) {}
+
+inline FusedSubstanceGrid::~FusedSubstanceGrid() {
+  if (group_ != nullptr) group_->Leave(this);
+}
+
+inline void FusedSubstanceGrid::Synchronize() {
+  if (group_ != nullptr) group_->Synchronize();
+}
+
+inline size_t FusedSubstanceGrid::GetNumFused() const {
+  return group_ != nullptr ? group_->GetNumSubstances() : 1;
+}
+
+inline void FusedSubstanceGrid::DiffuseGroup(real_t dt) { group_->Step(this, dt); }
+
+} // namespace bdm
+
+#endif // FUSED_SUBSTANCE_GRID_H_
@@ -0,0 +1,252 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef GROWTH_EVENTS_H_
+#define GROWTH_EVENTS_H_
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "biodynamo.h"
+#include "cell_growth.h"
+#include "counter_random.h"
+
+namespace bdm {
+
+/*
+Growth (and division) of a cell as in the 'CellGrowth' and
+'CellGrowthDivision' behaviors, with the parameters of a cell.
+A propability of 0 means that the cell never divides.
+*/
+struct GrowthParams {
+  real_t threshold = 10.0;
+  real_t growth_rate = 1.0;
+  real_t propability = 0.0;
+};
+
+/*
+Number of time steps a cell of the given diameter and volume keeps growing
+(by a constant volume rate) until its diameter exceeds the threshold, as
+checked by the 'CellGrowth' behavior at the start of every time step; the
+largest integer if it never does.
+*/
+inline uint64_t GrowthSteps(real_t diameter, real_t volume, const GrowthParams& growth,
+                            real_t dt) {
+  if (diameter > growth.threshold) return 0;
+  const real_t per_step = growth.growth_rate * dt;
+  if (per_step <= 0.0) return std::numeric_limits<uint64_t>::max();
+  const real_t threshold_volume = Math::kPi / 6.0 * std::pow(growth.threshold, 3);
+  const real_t k = std::floor((threshold_volume - volume) / per_step);
+  return k < 1e18 ? static_cast<uint64_t>(k) + 1 : std::numeric_limits<uint64_t>::max();
+}
+
+/*
+Alternative to the 'CellGrowth' and 'CellGrowthDivision' behaviors (without
+contact inhibition): a standalone operation that predicts when every one of
+its cells changes state, instead of checking every cell in every time step.
+A cell that is added (or born) computes the time step its diameter exceeds
+the threshold (see 'GrowthSteps'); until then it grows by its volume rate
+in one pass over the growing cells (the mechanics need its diameter every
+time step), and then it leaves that pass. A grown cell that divides draws
+the number of time steps it waits from the geometric distribution (see
+'GeometricSteps' in the 'counter_random.h' header file) instead of a random
+number every time step, and is put in a queue of events ordered by time
+step; so is a grown cell for 'TOnGrown'. Hence the cells that wait cost
+nothing, and the work per time step is the growing cells plus the events
+due. The division itself draws the volume
+ratio and the axis as the 'CellGrowthDivision' behavior does, the daughter
+inherits (a copy of) every behavior of the mother cell, and both start
+growing in the next time step.
+The waiting times have the same distribution as with the behaviors, but
+the random numbers (hence the cells that divide at a given time step) are
+not the same. The cells added to this operation should not carry a growth
+behavior; 'Add' may be called from the behaviors of other cells (e.g. the
+'StartGrowth' action of the migration in examples "ex07" to "ex09").
+Usage:
+  auto* growth = new GrowthEvents<Cell>();
+  auto* op = new Operation("growth events");
+  op->AddOperationImpl(kCpu, growth);
+  sim.GetScheduler()->ScheduleOp(op);
+  ...
+  growth->Add(cell, {threshold, growth_rate, propability});
+*/
+template <typename TAgent = Cell, typename TOnGrown = NoGrownAction>
+class GrowthEvents : public StandaloneOperationImpl {
+  BDM_OP_HEADER(GrowthEvents);
+
+  public:
+    GrowthEvents() = default;
+    explicit GrowthEvents(const TOnGrown& on_grown) : on_grown_(on_grown) {}
+
+    // add a cell, which starts growing in the current time step
+    void Add(Agent* cell, const GrowthParams& growth) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      added_.push_back({cell->GetUid(), growth});
+    }
+
+    size_t GetNumGrowing() const { return growing_.size(); }
+    size_t GetNumScheduled() const { return events_.size(); }
+
+    void operator()() override {
+      auto* sim = Simulation::GetActive();
+      auto* rm = sim->GetResourceManager();
+      const real_t dt = sim->GetParam()->simulation_time_step;
+      const uint64_t step = CounterRandom::GetStep(sim);
+
+      for (const auto& [uid, growth] : added_) {
+        if (rm->ContainsAgent(uid)) {
+          Enter(bdm_static_cast<TAgent*>(rm->GetAgent(uid)), growth, step, dt);
+        }
+      }
+      added_.clear();
+
+      // now increase the volume of every growing cell provided the
+      // (constant) speed by which its size increases
+      const size_t n = growing_.size();
+      alive_.resize(n);
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < n; ++i) {
+        const auto& cell = growing_[i];
+        alive_[i] = rm->ContainsAgent(cell.uid);
+        if (alive_[i]) {
+          bdm_static_cast<TAgent*>(rm->GetAgent(cell.uid))->ChangeVolume(cell.growth.growth_rate);
+        }
+      }
+
+      // the cells that grew for the last time are grown in the next time
+      // step; drop them, and those removed from the simulation
+      size_t k = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (!alive_[i]) continue;
+        if (growing_[i].last_step == step) {
+          Grown(growing_[i].uid, growing_[i].growth, step + 1);
+          continue;
+        }
+        growing_[k++] = growing_[i];
+      }
+      growing_.resize(k);
+
+      // the events due in this time step, in the order of the cells; the
+      // random numbers of the divisions are drawn in bulk (see
+      // 'CounterUniforms' in the 'counter_random.h' header file)
+      due_.clear();
+      due_uids_.clear();
+      while (!events_.empty() && events_.top().step <= step) {
+        due_.push_back(events_.top());
+        due_uids_.push_back(events_.top().uid);
+        events_.pop();
+      }
+      division_.resize(3 * due_.size());
+      CounterUniforms(sim->GetParam()->random_seed, due_uids_.data(), due_uids_.size(), step,
+                      kDivisionStream, 3, division_.data());
+      for (size_t i = 0; i < due_.size(); ++i) {
+        const Event& event = due_[i];
+        if (!rm->ContainsAgent(event.uid)) continue;
+        auto* cell = bdm_static_cast<TAgent*>(rm->GetAgent(event.uid));
+        if (event.growth.propability > 0.0) {
+          Divide(cell, event.growth, step, dt, &division_[3 * i]);
+        } else if constexpr (!std::is_same<TOnGrown, NoGrownAction>::value) {
+          on_grown_(cell);
+        }
+      }
+    }
+
+  private:
+    struct Growing {
+      AgentUid uid;
+      GrowthParams growth;
+      // the time step the cell grows for the last time
+      uint64_t last_step;
+    };
+
+    struct Event {
+      uint64_t step;
+      AgentUid uid;
+      GrowthParams growth;
+
+      // ordered by time step, then by cell (independent of the threads)
+      bool operator>(const Event& other) const {
+        if (step != other.step) return step > other.step;
+        if (uid.GetIndex() != other.uid.GetIndex()) return uid.GetIndex() > other.uid.GetIndex();
+        return uid.GetReused() > other.uid.GetReused();
+      }
+    };
+
+    // the cell starts growing at time step 'step'
+    void Enter(TAgent* cell, const GrowthParams& growth, uint64_t step, real_t dt) {
+      const uint64_t steps = GrowthSteps(cell->GetDiameter(), cell->GetVolume(), growth, dt);
+      if (steps == 0) {
+        Grown(cell->GetUid(), growth, step);
+      } else if (steps == std::numeric_limits<uint64_t>::max()) {
+        growing_.push_back({cell->GetUid(), growth, steps});
+      } else {
+        growing_.push_back({cell->GetUid(), growth, step + steps - 1});
+      }
+    }
+
+    // the cell is grown at time step 'step'; it divides at the first
+    // success of the Bernoulli trials from this time step on
+    void Grown(const AgentUid& uid, const GrowthParams& growth, uint64_t step) {
+      if (growth.propability > 0.0) {
+        const auto* param = Simulation::GetActive()->GetParam();
+        CounterRandom rand(param->random_seed, uid, step, kDivisionTimeStream);
+        const uint64_t wait = GeometricSteps(growth.propability, rand.Uniform());
+        if (wait != std::numeric_limits<uint64_t>::max()) {
+          events_.push({step + wait - 1, uid, growth});
+        }
+      } else if constexpr (!std::is_same<TOnGrown, NoGrownAction>::value) {
+        events_.push({step, uid, growth});
+      }
+    }
+
+    // divides the cell with the uniform random numbers u[0], u[1], u[2]
+    void Divide(TAgent* cell, const GrowthParams& growth, uint64_t step, real_t dt,
+                const real_t* u) {
+      // the volume ratio and the division axis are drawn as by
+      // 'Cell::Divide()', but from the stream of the division behavior
+      const real_t volume_ratio = 0.9 + 0.2 * u[0];
+      const real_t phi = 2.0 * Math::kPi * u[1];
+      const real_t theta = Math::kPi * u[2];
+      auto* new_cell = cell->Divide(volume_ratio, phi, theta);
+      // https://biodynamo.github.io/api/classbdm_1_1Agent.html#ac6ff7e2073bd2b3e4794bc8f0a8c26ed
+      for (const auto* b : cell->GetAllBehaviors()) {
+        new_cell->AddBehavior(b->NewCopy());
+      }
+      Enter(cell, growth, step + 1, dt);
+      Enter(bdm_static_cast<TAgent*>(new_cell), growth, step + 1, dt);
+    }
+
+    TOnGrown on_grown_;
+    // the cells added since the last time step
+    std::mutex mutex_;
+    std::vector<std::pair<AgentUid, GrowthParams>> added_;
+    // the growing cells, and the events of the grown ones
+    std::vector<Growing> growing_;
+    std::vector<uint8_t> alive_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    // scratch arrays of the events due in a time step
+    std::vector<Event> due_;
+    std::vector<AgentUid> due_uids_;
+    std::vector<real_t> division_;
+};
+
+} // namespace bdm
+
+#endif // GROWTH_EVENTS_H_
@@ -0,0 +1,219 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef MIXED_PRECISION_GRID_H_
+#define MIXED_PRECISION_GRID_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+#include "agent_voxels.h"
+#include "dirichlet_boundary.h"
+#include "stencil.h"
+#include "tiled_euler_grid.h"
+
+namespace bdm {
+
+// storage of the concentrations of a substance (see 'DefineSubstance')
+enum class SubstancePrecision { kFull, kFloat };
+
+/*
+Lattice of a substance stored in single precision: the time steps of the
+explicit finite differences (the tiled kernel of the 'tiled_euler_grid.h'
+header file, computed in real_t) stream through two float lattices, i.e.,
+half the memory traffic of a lattice of doubles.
+The concentrations seen by the agents (and by the simulation engine) are
+still the real_t lattice of the 'DiffusionGrid', which is kept up to date
+only where needed: every time step at the voxels of the agents, whose
+secretion (or uptake) is folded into the float lattice before the step, and
+on the whole lattice every 'sync_interval' time steps, every time step if
+the engine exports the visualization, and whenever 'Synchronize' is called
+(e.g. by the checkpoint and the asynchronous visualization). Hence, agents
+that read or change the concentration elsewhere than at their own voxel see
+values up to 'sync_interval' time steps old; secretion and uptake, as in
+examples "ex08" to "ex10", are exact.
+With 'EnableValidation' the same time steps are also computed in full
+precision (from the same secretion), and the largest and mean deviation of
+the float lattice from it are recorded every time step.
+Picked by 'DefineSubstance' for 'SubstancePrecision::kFloat' and
+'param->diffusion_method = "euler"' (see the 'substances.h' header file).
+*/
+class MixedPrecisionGrid : public DiffusionGrid {
+  public:
+    MixedPrecisionGrid() = default;
+    MixedPrecisionGrid(int substance_id, const std::string& substance_name,
+                       real_t diffusion_coeff, real_t decay_constant, int resolution = 10,
+                       uint64_t sync_interval = 10)
+      : DiffusionGrid(substance_id, substance_name, diffusion_coeff, decay_constant, resolution),
+        diffusion_coeff_(diffusion_coeff), sync_interval_(std::max<uint64_t>(sync_interval, 1)) {}
+
+    void DiffuseWithClosedEdge(real_t dt) override { Solve(dt, StencilEdge::kMirror, false); }
+    void DiffuseWithNeumann(real_t dt) override { Solve(dt, StencilEdge::kMirror, false); }
+    void DiffuseWithOpenEdge(real_t dt) override { Solve(dt, StencilEdge::kZero, false); }
+    void DiffuseWithPeriodic(real_t dt) override { Solve(dt, StencilEdge::kPeriodic, false); }
+    void DiffuseWithDirichlet(real_t dt) override { Solve(dt, StencilEdge::kMirror, true); }
+
+    // brings the whole real_t lattice up to date
+    void Synchronize() {
+      if (state_.size() != total_num_boxes_) return;
+      const size_t n = state_.size();
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < n; ++i) Sync(i);
+    }
+
+    // computes the time steps in full precision as well (before the first)
+    void EnableValidation() { validate_ = true; }
+
+    // largest (absolute) deviation from full precision over all time steps
+    real_t GetMaxDeviation() const { return max_deviation_; }
+    // mean (absolute) deviation from full precision over voxels and steps
+    real_t GetMeanDeviation() const {
+      return validated_steps_ > 0 ? sum_deviation_ / validated_steps_ : 0.0;
+    }
+    // largest concentration of full precision over all time steps
+    real_t GetMaxReference() const { return max_reference_; }
+    uint64_t GetValidatedSteps() const { return validated_steps_; }
+
+  private:
+    void Solve(real_t dt, StencilEdge edge, bool dirichlet) {
+      const size_t n = resolution_;
+      if (state_.size() != total_num_boxes_) {
+        // (re)started: from the concentration of the real_t lattice
+        Reload();
+      }
+      // the secretion since the last time step, at the voxels of the agents
+      // then and now
+      voxels_.Update(*this);
+      for (size_t i : voxels_.NowOrBefore()) Sync(i);
+
+      const real_t r = diffusion_coeff_ * dt / (box_length_ * box_length_);
+      const real_t keep = 1.0 - mu_ * dt;
+      TiledEulerGrid::Sweep<float>(n, r, keep, edge, state_.data(), next_.data(),
+                                   zeros_.data());
+      state_.swap(next_);
+      if (dirichlet) SetDirichletBoundary(*this, GetSimulatedTime(), &state_);
+      if (validate_) {
+        TiledEulerGrid::Sweep<real_t>(n, r, keep, edge, shadow_.data(), shadow_next_.data(),
+                                      shadow_zeros_.data());
+        shadow_.swap(shadow_next_);
+        if (dirichlet) SetDirichletBoundary(*this, GetSimulatedTime(), &shadow_);
+        RecordDeviation();
+      }
+
+      ++steps_;
+      const auto* param = Simulation::GetActive()->GetParam();
+      if (steps_ % sync_interval_ == 0 || param->export_visualization) {
+        Synchronize();
+      } else {
+        for (size_t i : voxels_.Now()) Sync(i);
+      }
+    }
+
+    /*
+    Folds the change of the real_t lattice at voxel i since it was last
+    synchronized (by the agents) into the float lattice, and copies the
+    latter back, so that both agree until the agents change it again.
+    */
+    void Sync(size_t i) {
+      const real_t delta = c1_[i] - base_[i];
+      if (delta != 0.0) {
+        state_[i] = static_cast<float>(state_[i] + delta);
+        if (validate_) shadow_[i] += delta;
+      }
+      base_[i] = state_[i];
+      c1_[i] = state_[i];
+    }
+
+    void Reload() {
+      const size_t n = total_num_boxes_;
+      state_.resize(n);
+      next_.resize(n);
+      base_.resize(n);
+      zeros_.assign(resolution_, 0.0f);
+      for (size_t i = 0; i < n; ++i) {
+        state_[i] = static_cast<float>(c1_[i]);
+        base_[i] = state_[i];
+      }
+      if (validate_) {
+        shadow_.assign(c1_.data(), c1_.data() + n);
+        shadow_next_.resize(n);
+        shadow_zeros_.assign(resolution_, 0.0);
+      }
+      for (size_t i = 0; i < n; ++i) c1_[i] = state_[i];
+      voxels_.Clear();
+    }
+
+    void RecordDeviation() {
+      const size_t n = state_.size();
+      real_t max = 0.0, sum = 0.0, reference = 0.0;
+#pragma omp parallel for simd schedule(static) reduction(max:max, reference) reduction(+:sum)
+      for (size_t i = 0; i < n; ++i) {
+        const real_t deviation = std::abs(state_[i] - shadow_[i]);
+        max = std::max(max, deviation);
+        sum += deviation;
+        reference = std::max(reference, std::abs(shadow_[i]));
+      }
+      max_deviation_ = std::max(max_deviation_, max);
+      sum_deviation_ += sum / std::max<size_t>(n, 1);
+      max_reference_ = std::max(max_reference_, reference);
+      ++validated_steps_;
+    }
+
+    real_t diffusion_coeff_ = 0.0;
+    uint64_t sync_interval_ = 10;
+    uint64_t steps_ = 0;
+    // the float lattice (and its next time step), and the value of every
+    // voxel when it was last copied to the real_t lattice
+    std::vector<float> state_, next_, base_;
+    std::vector<float> zeros_;
+    AgentVoxels voxels_;
+    // the lattice in full precision (if validated)
+    bool validate_ = false;
+    std::vector<real_t> shadow_, shadow_next_, shadow_zeros_;
+    real_t max_deviation_ = 0.0, sum_deviation_ = 0.0, max_reference_ = 0.0;
+    uint64_t validated_steps_ = 0;
+
+    BDM_CLASS_DEF_OVERRIDE(MixedPrecisionGrid, 1);
+};
+
+/*
+Linear 16-bit quantization of the n concentrations c into q, for a compact
+export: c = offset + scale * q, with an error of at most scale / 2, i.e.,
+1 / 131070 of the range of the concentrations.
+*/
+struct Quantization {
+  real_t offset = 0.0;
+  real_t scale = 0.0;
+};
+
+inline Quantization Quantize16(const real_t* c, size_t n, uint16_t* q) {
+  Quantization quantization;
+  if (n == 0) return quantization;
+  const auto [min, max] = std::minmax_element(c, c + n);
+  quantization.offset = *min;
+  quantization.scale = (*max - *min) / 65535.0;
+  const real_t inverse = quantization.scale > 0.0 ? 1.0 / quantization.scale : 0.0;
+#pragma omp parallel for simd schedule(static)
+  for (size_t i = 0; i < n; ++i) {
+    q[i] = static_cast<uint16_t>(std::lround((c[i] - quantization.offset) * inverse));
+  }
+  return quantization;
+}
+
+} // namespace bdm
+
+#endif // MIXED_PRECISION_GRID_H_
@@ -0,0 +1,234 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef NEIGHBOR_INDEX_H_
+#define NEIGHBOR_INDEX_H_
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+Result of a neighbor query: the neighbor found (if any) together with its
+squared distance from the query position.
+*/
+struct NeighborHit {
+  Agent* agent = nullptr;
+  real_t squared_distance = 0.0;
+
+  explicit operator bool() const { return agent != nullptr; }
+};
+
+/*
+Uniform grid of boxes over the positions of all agents, rebuilt once per
+time step (as a pre-scheduled standalone operation), that answers "is there
+any neighbor matching a predicate" queries. As opposed to the engine's
+'ForEachNeighbor', a query stops at the first match, the predicate is
+inlined (no 'Functor' call per neighbor) and it is given the squared
+distance that the index already computed.
+Optionally, the agents are partitioned (e.g. by phenotype or by agent type)
+into as many separate grids, so that a query for neighbors of a partition
+(e.g. "any cell of another phenotype") scans only the agents of it.
+Usage:
+  auto* neighbors = new NeighborIndex(box_length);
+  // or, with 2 partitions (the function returns either 0 or 1)
+  // auto* neighbors = new NeighborIndex(box_length, 2, partition);
+  auto* op = new Operation("neighbor index");
+  op->AddOperationImpl(kCpu, neighbors);
+  sim.GetScheduler()->ScheduleOp(op, OpType::kPreSchedule);
+  ...
+  if (neighbors->FindAny(*cell, squared_radius, [](Agent* a, real_t d2) {...}))
+*/
+class NeighborIndex : public StandaloneOperationImpl {
+  BDM_OP_HEADER(NeighborIndex);
+
+  public:
+    // maps an agent to its partition, in [0, number of partitions)
+    using Partition = std::function<int(const Agent*)>;
+
+    NeighborIndex() = default;
+    explicit NeighborIndex(real_t box_length) : box_length_(box_length) {}
+    NeighborIndex(real_t box_length, int num_partitions, const Partition& partition)
+      : box_length_(box_length), num_partitions_(num_partitions), partition_(partition) {}
+
+    void operator()() override { Update(); }
+
+    // rebuild the index from the current positions of all agents
+    void Update() {
+      if (box_length_ <= 0.0) {
+        Log::Fatal("NeighborIndex::Update", "box length must be positive");
+      }
+      if (num_partitions_ <= 0) {
+        Log::Fatal("NeighborIndex::Update", "number of partitions must be positive");
+      }
+      auto* rm = Simulation::GetActive()->GetResourceManager();
+      agents_.clear();
+      // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
+      rm->ForEachAgent([&](Agent* agent) { agents_.push_back(agent); });
+      const size_t n = agents_.size();
+
+      // bounding box of the agents (that may leave an open domain)
+      Real3 upper;
+      for (int d = 0; d < 3; ++d) {
+        lower_[d] = std::numeric_limits<real_t>::max();
+        upper[d] = std::numeric_limits<real_t>::lowest();
+        dims_[d] = 1;
+      }
+      for (const auto* agent : agents_) {
+        const Real3& xyz = agent->GetPosition();
+        for (int d = 0; d < 3; ++d) {
+          lower_[d] = std::min(lower_[d], xyz[d]);
+          upper[d] = std::max(upper[d], xyz[d]);
+        }
+      }
+      if (n != 0) {
+        for (int d = 0; d < 3; ++d) {
+          dims_[d] = static_cast<int>((upper[d] - lower_[d]) / box_length_) + 1;
+        }
+      }
+
+      // counting sort of the agents by partition and box, such that the
+      // agents of a box (and their positions) are contiguous in memory
+      num_boxes_ = static_cast<size_t>(dims_[0]) * dims_[1] * dims_[2];
+      box_.resize(n);
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < n; ++i) {
+        const Real3& xyz = agents_[i]->GetPosition();
+        const int p = partition_ ? partition_(agents_[i]) : 0;
+        box_[i] = (p < 0 || p >= num_partitions_)
+                      ? kInvalidBox
+                      : p * num_boxes_ + Box(BoxCoord(xyz[0], 0), BoxCoord(xyz[1], 1),
+                                             BoxCoord(xyz[2], 2));
+      }
+      if (std::find(box_.begin(), box_.end(), kInvalidBox) != box_.end()) {
+        Log::Fatal("NeighborIndex::Update", "agent partition out of range");
+      }
+      start_.assign(num_partitions_ * num_boxes_ + 1, 0);
+      for (size_t i = 0; i < n; ++i) ++start_[box_[i] + 1];
+      for (size_t b = 1; b < start_.size(); ++b) start_[b] += start_[b - 1];
+      sorted_.resize(n);
+      x_.resize(n);
+      y_.resize(n);
+      z_.resize(n);
+      std::vector<uint32_t> next(start_.begin(), start_.end() - 1);
+      for (size_t i = 0; i < n; ++i) {
+        const uint32_t j = next[box_[i]]++;
+        const Real3& xyz = agents_[i]->GetPosition();
+        sorted_[j] = agents_[i];
+        x_[j] = xyz[0];
+        y_[j] = xyz[1];
+        z_[j] = xyz[2];
+      }
+    }
+
+    /*
+    Returns the first agent (other than 'query') of the given partition
+    (or of any partition if negative) found closer than the squared radius
+    to the position for which 'pred(agent, squared_distance)' holds, or an
+    empty hit if there is none.
+    */
+    template <typename TPredicate>
+    NeighborHit FindAny(const Real3& position, real_t squared_radius,
+                        const Agent* query, int partition, TPredicate&& pred) const {
+      if (sorted_.empty()) return {};
+      const real_t radius = std::sqrt(squared_radius);
+      int from[3], to[3];
+      for (int d = 0; d < 3; ++d) {
+        from[d] = BoxCoord(position[d] - radius, d);
+        to[d] = BoxCoord(position[d] + radius, d);
+      }
+      const int first = partition < 0 ? 0 : partition;
+      const int last = partition < 0 ? num_partitions_ - 1 : partition;
+      for (int p = first; p <= last; ++p) {
+        const size_t offset = p * num_boxes_;
+        for (int k = from[2]; k <= to[2]; ++k) {
+          for (int j = from[1]; j <= to[1]; ++j) {
+            // the boxes along x are contiguous, hence so are their agents
+            const uint32_t end = start_[offset + Box(to[0], j, k) + 1];
+            for (uint32_t i = start_[offset + Box(from[0], j, k)]; i < end; ++i) {
+              const real_t dx = x_[i] - position[0];
+              const real_t dy = y_[i] - position[1];
+              const real_t dz = z_[i] - position[2];
+              const real_t d2 = dx * dx + dy * dy + dz * dz;
+              if (d2 < squared_radius && sorted_[i] != query && pred(sorted_[i], d2)) {
+                return {sorted_[i], d2};
+              }
+            }
+          }
+        }
+      }
+      return {};
+    }
+
+    // same as above, around (and excluding) the given agent
+    template <typename TPredicate>
+    NeighborHit FindAny(const Agent& query, real_t squared_radius, int partition,
+                        TPredicate&& pred) const {
+      return FindAny(query.GetPosition(), squared_radius, &query, partition,
+                     std::forward<TPredicate>(pred));
+    }
+
+    // same as above, for any agent of the given partition
+    NeighborHit FindAny(const Agent& query, real_t squared_radius, int partition) const {
+      return FindAny(query, squared_radius, partition, [](Agent*, real_t) { return true; });
+    }
+
+    // same as above, in all partitions
+    template <typename TPredicate>
+    NeighborHit FindAny(const Agent& query, real_t squared_radius, TPredicate&& pred) const {
+      return FindAny(query, squared_radius, -1, std::forward<TPredicate>(pred));
+    }
+
+    real_t GetBoxLength() const { return box_length_; }
+    int GetNumPartitions() const { return num_partitions_; }
+    int GetPartition(const Agent* agent) const { return partition_ ? partition_(agent) : 0; }
+    size_t GetNumAgents() const { return sorted_.size(); }
+
+  private:
+    int BoxCoord(real_t v, int d) const {
+      const real_t c = std::floor((v - lower_[d]) / box_length_);
+      return static_cast<int>(std::clamp<real_t>(c, 0, dims_[d] - 1));
+    }
+    size_t Box(int i, int j, int k) const {
+      return (static_cast<size_t>(k) * dims_[1] + j) * dims_[0] + i;
+    }
+
+    real_t box_length_ = 1.0;
+    static constexpr size_t kInvalidBox = std::numeric_limits<size_t>::max();
+
+    int num_partitions_ = 1;
+    Partition partition_;
+    Real3 lower_;
+    int dims_[3] = {1, 1, 1};
+    size_t num_boxes_ = 1;
+    // the agents (and their positions) sorted by partition and box; the
+    // agents of box b of partition p are [start_[s], start_[s+1]), where
+    // s = p * num_boxes_ + b
+    std::vector<Agent*> sorted_;
+    std::vector<real_t> x_, y_, z_;
+    std::vector<uint32_t> start_;
+    // scratch arrays of every update
+    std::vector<Agent*> agents_;
+    std::vector<size_t> box_;
+};
+
+} // namespace bdm
+
+#endif // NEIGHBOR_INDEX_H_
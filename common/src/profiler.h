@@ -0,0 +1,343 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+Call count, total and maximum time, and histogram of the times (bin b counts
+the calls that took [2^b, 2^(b+1)) nanoseconds, the last one also longer).
+*/
+struct TimingStats {
+  static constexpr int kBins = 28;
+
+  uint64_t calls = 0;
+  uint64_t total_ns = 0;
+  uint64_t max_ns = 0;
+  std::array<uint64_t, kBins> histogram = {};
+
+  void Add(uint64_t ns) {
+    ++calls;
+    total_ns += ns;
+    max_ns = std::max(max_ns, ns);
+    const int bin = ns == 0 ? 0 : 63 - __builtin_clzll(ns);
+    ++histogram[std::min(bin, kBins - 1)];
+  }
+
+  void Merge(const TimingStats& other) {
+    calls += other.calls;
+    total_ns += other.total_ns;
+    max_ns = std::max(max_ns, other.max_ns);
+    for (int b = 0; b < kBins; ++b) histogram[b] += other.histogram[b];
+  }
+
+  // upper bound of the time (in nanoseconds) of the given fraction of calls
+  uint64_t Percentile(real_t fraction) const {
+    uint64_t count = 0;
+    for (int b = 0; b < kBins; ++b) {
+      count += histogram[b];
+      if (count >= fraction * calls) return std::min<uint64_t>(2ull << b, max_ns);
+    }
+    return max_ns;
+  }
+};
+
+/*
+Index of the behavior run by 'Agent::RunBehaviors', which
+'Agent::RemoveBehavior' corrects when it removes a behavior at or before it.
+The member is private, hence it is named through an explicit instantiation
+(exempt from access checks), once per program like the rest of this header.
+*/
+uint32_t Agent::*BehaviorLoopIndex();
+
+template <uint32_t Agent::*kIndex>
+struct BehaviorLoopIndexOf {
+  friend uint32_t Agent::*BehaviorLoopIndex() { return kIndex; }
+};
+
+template struct BehaviorLoopIndexOf<&Agent::run_behavior_loop_idx_>;
+
+/*
+Opt-in instrumentation of a simulation: the time of every behavior 'Run'
+call (per behavior type) and of every scheduled operation (per agent for
+agent operations) is accumulated per group of agents, e.g. per phenotype,
+in accumulators local to each thread (hence the times of agent operations
+add up over the threads). Every 'interval' time steps the
+statistics of the last interval are appended to a CSV file, and the
+statistics of the whole simulation are printed as a table by 'PrintSummary'.
+Usage:
+  auto* profiler = new Profiler("profile.csv", 100, "phenotype",
+                                [](const Agent* agent) { return ...; });
+  profiler->Install(sim.GetScheduler());
+  sim.GetScheduler()->Simulate(steps);
+  profiler->PrintSummary();
+*/
+class Profiler : public StandaloneOperationImpl {
+  BDM_OP_HEADER(Profiler);
+
+  public:
+    // maps an agent to its group (e.g. its phenotype)
+    using Group = std::function<int(const Agent*)>;
+
+    Profiler() = default;
+    Profiler(const std::string& csv_file, uint64_t interval,
+             const std::string& group_name = "group", const Group& group = nullptr)
+      : csv_file_(csv_file), interval_(std::max<uint64_t>(interval, 1)),
+        group_name_(group_name), group_(group),
+        threads_(ThreadInfo::GetInstance()->GetMaxThreads()) {
+      for (auto& thread : threads_) thread = std::make_shared<ThreadStats>();
+    }
+
+    /*
+    Wraps the implementation of every scheduled operation of the scheduler
+    into a timed one (and replaces the one running the behaviors) and
+    schedules this profiler after every time step.
+    */
+    void Install(Scheduler* scheduler) {
+      auto names = scheduler->GetListOfScheduledAgentOps();
+      for (const auto& name : scheduler->GetListOfScheduledStandaloneOps()) {
+        names.push_back(name);
+      }
+      for (const auto& name : names) {
+        for (auto* op : scheduler->GetOps(name)) {
+          // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+          auto*& impl = op->implementations_[kCpu];
+          if (name == "behavior") {
+            delete impl;
+            impl = new TimedBehaviors(this);
+          } else if (impl->IsStandalone()) {
+            impl = new TimedStandaloneOp(this, op->name_, static_cast<StandaloneOperationImpl*>(impl));
+          } else {
+            impl = new TimedAgentOp(this, op->name_, static_cast<AgentOperationImpl*>(impl));
+          }
+        }
+      }
+      auto* op = new Operation("profiler");
+      op->AddOperationImpl(kCpu, this);
+      scheduler->ScheduleOp(op, OpType::kPostSchedule);
+    }
+
+    // accumulate the time of a call of the given category (thread-safe)
+    void Record(const void* id, const char* name, const Agent* agent, uint64_t ns) {
+      const int group = (agent != nullptr && group_) ? group_(agent) : -1;
+      auto& entries = threads_[ThreadInfo::GetInstance()->GetMyThreadId()]->entries;
+      for (auto& entry : entries) {
+        if (entry.id == id && entry.group == group) {
+          entry.stats.Add(ns);
+          return;
+        }
+      }
+      entries.push_back({id, name, group, {}});
+      entries.back().stats.Add(ns);
+    }
+
+    // append the statistics of the last interval to the CSV file
+    void operator()() override {
+      const uint64_t step = Simulation::GetActive()->GetScheduler()->GetSimulatedSteps() + 1;
+      if (step % interval_ != 0) return;
+      std::vector<Entry> interval = Collect(true);
+      std::ofstream csv(csv_file_, first_write_ ? std::ios::trunc : std::ios::app);
+      if (first_write_) {
+        csv << "step,category," << group_name_ << ",calls,total_ms,mean_us,max_us";
+        for (int b = 0; b < TimingStats::kBins; ++b) csv << ",hist_" << (1ull << b) << "ns";
+        csv << "\n";
+        first_write_ = false;
+      }
+      for (const auto& entry : interval) {
+        const auto& s = entry.stats;
+        csv << step << ",\"" << Demangle(entry.name) << "\"," << entry.group << ","
+            << s.calls << "," << s.total_ns * 1e-6 << "," << 1e-3 * s.total_ns / s.calls
+            << "," << s.max_ns * 1e-3;
+        for (int b = 0; b < TimingStats::kBins; ++b) csv << "," << s.histogram[b];
+        csv << "\n";
+      }
+    }
+
+    // print the statistics of the whole simulation as a table
+    void PrintSummary() {
+      Collect(true);
+      std::sort(totals_.begin(), totals_.end(), [](const Entry& a, const Entry& b) {
+        return a.stats.total_ns > b.stats.total_ns;
+      });
+      uint64_t total_ns = 0;
+      for (const auto& entry : totals_) total_ns += entry.stats.total_ns;
+
+      std::printf("%-50s %9s %12s %10s %7s %10s %10s %10s\n", "category",
+                  group_name_.c_str(), "calls", "total[s]", "share", "mean[us]",
+                  "p95[us]", "max[us]");
+      for (const auto& entry : totals_) {
+        const auto& s = entry.stats;
+        std::printf("%-50.50s %9d %12llu %10.3f %6.1f%% %10.3f %10.3f %10.3f\n",
+                    Demangle(entry.name).c_str(), entry.group,
+                    static_cast<unsigned long long>(s.calls), s.total_ns * 1e-9,
+                    100.0 * s.total_ns / std::max<uint64_t>(total_ns, 1),
+                    1e-3 * s.total_ns / s.calls, 1e-3 * s.Percentile(0.95), 1e-3 * s.max_ns);
+      }
+    }
+
+  private:
+    struct Entry {
+      const void* id;
+      const char* name;
+      int group;
+      TimingStats stats;
+    };
+    // accumulators of a thread (allocated separately, hence no false sharing)
+    struct ThreadStats {
+      std::vector<Entry> entries;
+    };
+
+    static void Merge(std::vector<Entry>* entries, const Entry& entry) {
+      for (auto& e : *entries) {
+        if (e.id == entry.id && e.group == entry.group) {
+          e.stats.Merge(entry.stats);
+          return;
+        }
+      }
+      entries->push_back(entry);
+    }
+
+    // statistics of all threads since the last call (or the start)
+    std::vector<Entry> Collect(bool reset) {
+      std::vector<Entry> entries;
+      for (auto& thread : threads_) {
+        for (const auto& entry : thread->entries) Merge(&entries, entry);
+        if (reset) thread->entries.clear();
+      }
+      for (const auto& entry : entries) Merge(&totals_, entry);
+      return entries;
+    }
+
+    static std::string Demangle(const char* name) {
+      int status = 0;
+      char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+      std::string ret = status == 0 ? demangled : name;
+      std::free(demangled);
+      // shorten the names of the types of the simulation engine
+      for (size_t pos; (pos = ret.find("bdm::")) != std::string::npos;) ret.erase(pos, 5);
+      return ret;
+    }
+
+    static uint64_t Now() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /*
+    Replacement of the operation running the behaviors of an agent, which
+    times every 'Run' call. It is the loop of 'Agent::RunBehaviors' on the
+    agent's own index, hence removed and added behaviors (also one taking
+    the address of a removed one) are handled as by the engine.
+    */
+    class TimedBehaviors : public AgentOperationImpl {
+      BDM_OP_HEADER(TimedBehaviors);
+
+      public:
+        TimedBehaviors() = default;
+        explicit TimedBehaviors(Profiler* profiler) : profiler_(profiler) {}
+
+        void operator()(Agent* agent) override {
+          const auto& behaviors = agent->GetAllBehaviors();
+          uint32_t& i = agent->*BehaviorLoopIndex();
+          for (i = 0; i < behaviors.size(); ++i) {
+            Behavior* behavior = behaviors[i];
+            // the behavior may be deleted during the call
+            const std::type_info& type = typeid(*behavior);
+            const uint64_t start = Now();
+            behavior->Run(agent);
+            profiler_->Record(&type, type.name(), agent, Now() - start);
+          }
+        }
+
+      private:
+        Profiler* profiler_ = nullptr;
+    };
+
+    // an agent operation timed per agent
+    class TimedAgentOp : public AgentOperationImpl {
+      BDM_OP_HEADER(TimedAgentOp);
+
+      public:
+        TimedAgentOp() = default;
+        TimedAgentOp(Profiler* profiler, const std::string& name, AgentOperationImpl* impl)
+          : profiler_(profiler), name_(std::make_shared<std::string>(name)), impl_(impl) {}
+
+        void SetUp() override { impl_->SetUp(); }
+        void TearDown() override { impl_->TearDown(); }
+        void operator()(Agent* agent) override {
+          const uint64_t start = Now();
+          (*impl_)(agent);
+          profiler_->Record(name_.get(), name_->c_str(), agent, Now() - start);
+        }
+
+      private:
+        Profiler* profiler_ = nullptr;
+        std::shared_ptr<std::string> name_;
+        std::shared_ptr<AgentOperationImpl> impl_;
+    };
+
+    // a standalone operation timed per call
+    class TimedStandaloneOp : public StandaloneOperationImpl {
+      BDM_OP_HEADER(TimedStandaloneOp);
+
+      public:
+        TimedStandaloneOp() = default;
+        TimedStandaloneOp(Profiler* profiler, const std::string& name,
+                          StandaloneOperationImpl* impl)
+          : profiler_(profiler), name_(std::make_shared<std::string>(name)), impl_(impl) {}
+
+        void SetUp() override { impl_->SetUp(); }
+        void TearDown() override { impl_->TearDown(); }
+        void operator()() override {
+          const uint64_t start = Now();
+          (*impl_)();
+          profiler_->Record(name_.get(), name_->c_str(), nullptr, Now() - start);
+        }
+
+      private:
+        Profiler* profiler_ = nullptr;
+        std::shared_ptr<std::string> name_;
+        std::shared_ptr<StandaloneOperationImpl> impl_;
+    };
+
+    std::string csv_file_;
+    uint64_t interval_ = 1;
+    bool first_write_ = true;
+    std::string group_name_ = "group";
+    Group group_;
+    std::vector<std::shared_ptr<ThreadStats>> threads_;
+    // statistics of the whole simulation
+    std::vector<Entry> totals_;
+};
+
+} // namespace bdm
+
+#endif // PROFILER_H_
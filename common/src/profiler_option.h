@@ -0,0 +1,63 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef PROFILER_OPTION_H_
+#define PROFILER_OPTION_H_
+
+#include <string>
+
+#include "biodynamo.h"
+#include "profiler.h"
+#include "scenario.h"
+
+namespace bdm {
+
+/*
+Option of the scenario (see the 'scenario.h' header file) that times every
+behavior and operation (see the 'profiler.h' header file), grouped by the
+agent groups of the scenario:
+  --profile  writes the timings to 'profile.csv' in the output folder every
+             given number of steps and prints a summary at the end
+To be added before the work stealing (see the 'work_stealing_option.h'
+header file), which then runs the timed behaviors.
+*/
+class ProfilerOption : public ScenarioOption {
+  public:
+    explicit ProfilerOption(CommandLineOptions* clo) {
+      clo->AddOption<uint64_t>("profile", "0", "Time behaviors and operations, writing a CSV every given steps (0 disables)");
+    }
+
+    void Apply(const Scenario&, CommandLineOptions* clo, Param*) override {
+      interval_ = clo->Get<uint64_t>("profile");
+    }
+
+    void Install(const Scenario& scenario, Simulation* sim, uint64_t*) override {
+      if (interval_ == 0) return;
+      profiler_ = new Profiler(sim->GetOutputDir() + "/profile.csv", interval_,
+                               scenario.GetGroupName(), scenario.GetGroup());
+      // the scheduler takes over the profiler operation
+      profiler_->Install(sim->GetScheduler());
+    }
+
+    void PrintSummary() override {
+      if (profiler_ != nullptr) profiler_->PrintSummary();
+    }
+
+  private:
+    uint64_t interval_ = 0;
+    Profiler* profiler_ = nullptr;
+};
+
+} // namespace bdm
+
+#endif // PROFILER_OPTION_H_
@@ -0,0 +1,235 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef SCENARIO_H_
+#define SCENARIO_H_
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+Standalone operation that accumulates the number of agents at the beginning
+of every time step, i.e., the number of agent updates.
+*/
+struct AgentUpdateCounter : public StandaloneOperationImpl {
+  BDM_OP_HEADER(AgentUpdateCounter);
+
+  public:
+    AgentUpdateCounter() = default;
+    explicit AgentUpdateCounter(uint64_t* updates) : updates_(updates) {}
+
+    void operator()() override {
+      *updates_ += Simulation::GetActive()->GetResourceManager()->GetNumAgents();
+    }
+
+  private:
+    uint64_t* updates_ = nullptr;
+};
+
+class Scenario;
+
+/*
+Optional feature of the examples with its own command line options, which
+an example opts into by adding it to its scenario (see 'Scenario::Add'),
+e.g. the profiler of the 'profiler_option.h' header file. An option adds
+its command line options when constructed, reads them in 'Apply' and
+installs its operations in 'Install'.
+*/
+class ScenarioOption {
+  public:
+    virtual ~ScenarioOption() = default;
+
+    // called by 'Scenario::Apply', after the options of the scenario are read
+    virtual void Apply(const Scenario& scenario, CommandLineOptions* clo, Param* param) = 0;
+    // called by 'Scenario::Simulate' before the time steps, which it may
+    // reduce (e.g. to the remaining ones of a restarted simulation)
+    virtual void Install(const Scenario&, Simulation*, uint64_t*) {}
+    // right after the time steps, as part of the timed run
+    virtual void Finish() {}
+    // after the timed run, before the report
+    virtual void PrintSummary() {}
+};
+
+/*
+Command line options shared by the examples, which allow the same model to
+be run at larger sizes and without visualization, e.g.:
+  ./build/ex06 --scale 10 --headless --report ex06.jsonl
+  --scale    multiplies the number of agents and the volume of the simulation
+             domain (hence, the number of voxels of the substance lattices)
+             by the given factor, so that the density of the model remains
+  --headless disables the export of visualization data and the progress bar
+  --steps    overrides the number of simulated time steps
+  --report   appends the wall time, agent updates per second and peak memory
+             of the run as a JSON line to the given file ("-" for stdout)
+The options are read by 'Apply'. The examples opt into further features
+with their own options (see 'Add'), each from a header file of its own:
+  --profile                  'profiler_option.h'
+  --checkpoint, --restart    'checkpoint_option.h'
+  --async-visualization, --quantize-visualization
+                             'async_visualization_option.h'
+  --diffusion-method, --substance-precision
+                             'substance_option.h'
+  --adaptive-parallelism     'adaptive_parallelism_option.h'
+  --work-stealing            'work_stealing_option.h'
+*/
+class Scenario {
+  public:
+    Scenario(const std::string& name, CommandLineOptions* clo) : name_(name), clo_(clo) {
+      // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+      clo->AddOption<real_t>("scale", "1", "Scale factor of the number of agents and the domain volume");
+      clo->AddOption<bool>("headless", "false", "Disable the visualization export and the progress bar");
+      clo->AddOption<uint64_t>("steps", "0", "Number of time steps (0 keeps the default of the example)");
+      clo->AddOption<std::string>("report", "", "File to append the performance report to (- for stdout)");
+    }
+
+    /*
+    Adds an optional feature (a 'ScenarioOption'), constructed from the
+    command line options and the given arguments, before the command line
+    options are read (i.e., before the example reads its own), e.g.:
+      auto* profiler = scenario.Add<ProfilerOption>(&clo);
+    Its operations are installed by 'Simulate' in the order of the calls.
+    */
+    template <typename TOption, typename... TArgs>
+    TOption* Add(CommandLineOptions* clo, TArgs&&... args) {
+      auto* option = new TOption(clo, std::forward<TArgs>(args)...);
+      options_.emplace_back(option);
+      return option;
+    }
+
+    /*
+    Groups the agents by some property, e.g. their phenotype, for the
+    options that report or export it (e.g. the profiler and the
+    asynchronous visualization).
+    */
+    void SetAgentGroups(const std::string& name, const std::function<int(const Agent*)>& group) {
+      group_name_ = name;
+      group_ = group;
+    }
+    const std::string& GetGroupName() const { return group_name_; }
+    const std::function<int(const Agent*)>& GetGroup() const { return group_; }
+
+    /*
+    To be called at the end of the user-defined function that sets the
+    global parameters of the simulation.
+    */
+    void Apply(Param* param) {
+      scale_ = std::max<real_t>(clo_->Get<real_t>("scale"), 0.0);
+      headless_ = clo_->Get<bool>("headless");
+      steps_ = clo_->Get<uint64_t>("steps");
+      report_ = clo_->Get<std::string>("report");
+      param->max_bound = param->min_bound + Length(param->max_bound-param->min_bound);
+      if (headless_) {
+        param->export_visualization = false;
+        param->use_progress_bar = false;
+      }
+      for (auto& option : options_) option->Apply(*this, clo_, param);
+    }
+
+    // number of agents (at least one)
+    uint64_t Agents(uint64_t n) const {
+      return std::max<uint64_t>(std::llround(n * scale_), 1);
+    }
+    // number of agents (at least two) along each dimension of a grid
+    size_t PerDim(size_t n) const {
+      return std::max<size_t>(std::lround(n * std::cbrt(scale_)), 2);
+    }
+    // number of voxels along each dimension of a substance lattice
+    int Resolution(int n) const {
+      return std::max<int>(std::lround(n * std::cbrt(scale_)), 2);
+    }
+    // length along each dimension of the simulation domain
+    real_t Length(real_t length) const {
+      return length * std::cbrt(scale_);
+    }
+    uint64_t Steps(uint64_t n) const { return (steps_ > 0 ? steps_ : n); }
+
+    /*
+    Simulates the given (unless overridden) number of time steps and
+    writes the performance report.
+    */
+    void Simulate(Simulation* sim, uint64_t steps) {
+      auto* scheduler = sim->GetScheduler();
+      auto* rm = sim->GetResourceManager();
+      steps = Steps(steps);
+
+      uint64_t updates = 0;
+      // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+      auto* op = new Operation("agent update counter");
+      op->AddOperationImpl(kCpu, new AgentUpdateCounter(&updates));
+      scheduler->ScheduleOp(op, OpType::kPreSchedule);
+
+      for (auto& option : options_) option->Install(*this, sim, &steps);
+
+      const uint64_t agents = rm->GetNumAgents();
+      const auto start = std::chrono::steady_clock::now();
+      scheduler->Simulate(steps);
+      for (auto& option : options_) option->Finish();
+      const std::chrono::duration<real_t> elapsed = std::chrono::steady_clock::now() - start;
+
+      for (auto& option : options_) option->PrintSummary();
+
+      if (report_.empty()) return;
+      // peak resident set size (in kilobytes on Linux)
+      rusage usage;
+      getrusage(RUSAGE_SELF, &usage);
+
+      char line[512];
+      std::snprintf(line, sizeof(line),
+                    "{\"scenario\": \"%s\", \"scale\": %g, \"steps\": %llu, "
+                    "\"initial_agents\": %llu, \"final_agents\": %llu, "
+                    "\"wall_time_s\": %.6f, \"agent_updates\": %llu, "
+                    "\"agent_updates_per_s\": %.1f, \"peak_rss_kb\": %ld}",
+                    name_.c_str(), scale_, static_cast<unsigned long long>(steps),
+                    static_cast<unsigned long long>(agents),
+                    static_cast<unsigned long long>(rm->GetNumAgents()),
+                    elapsed.count(), static_cast<unsigned long long>(updates),
+                    updates / elapsed.count(), usage.ru_maxrss);
+      if (report_ == "-") {
+        std::cout << line << std::endl;
+      } else {
+        std::ofstream(report_, std::ios::app) << line << std::endl;
+      }
+    }
+
+    real_t GetScale() const { return scale_; }
+    bool IsHeadless() const { return headless_; }
+
+  private:
+    std::string name_;
+    CommandLineOptions* clo_ = nullptr;
+    real_t scale_ = 1.0;
+    bool headless_ = false;
+    uint64_t steps_ = 0;
+    std::string report_;
+    std::string group_name_ = "group";
+    std::function<int(const Agent*)> group_;
+    std::vector<std::unique_ptr<ScenarioOption>> options_;
+};
+
+} // namespace bdm
+
+#endif // SCENARIO_H_
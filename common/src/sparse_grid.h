@@ -0,0 +1,217 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef SPARSE_GRID_H_
+#define SPARSE_GRID_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+#include "agent_voxels.h"
+#include "dirichlet_boundary.h"
+#include "stencil.h"
+
+namespace bdm {
+
+/*
+Lattice of a substance split into blocks of 8 times 8 times 8 voxels, of
+which only the active ones are updated by the explicit finite differences
+(the same stencil as the one of the simulation engine) every time step.
+A block is active if it holds a concentration above the given threshold,
+or if it is next to such a block, since the concentration spreads by at
+most one voxel per time step; the concentration of the other blocks, which
+is negligible, is left unchanged. The largest concentration of a block is
+taken after its last update, and at the voxels of the agents (now and at
+the previous time step, see the 'agent_voxels.h' header file), whose
+secretion may have raised it since: a block becomes active as soon as an
+agent secretes into it, whereas the agents that take up the substance where
+it is absent leave their blocks inactive. Hence, the time of a step scales
+with the region where the substance is present, e.g. around the secreting
+cells early in a simulation, instead of with the whole lattice.
+The concentrations are still stored in the arrays of the whole lattice, so
+that the secretion of the agents, the gradients and the visualization of
+the substance work as for any other lattice.
+Selected with 'param->diffusion_method = "sparse"' (see the 'substances.h'
+header file).
+*/
+class SparseGrid : public DiffusionGrid {
+  public:
+    static constexpr size_t kBlock = 8;
+
+    SparseGrid() = default;
+    SparseGrid(int substance_id, const std::string& substance_name, real_t diffusion_coeff,
+               real_t decay_constant, int resolution = 10, real_t threshold = 1e-9)
+      : DiffusionGrid(substance_id, substance_name, diffusion_coeff, decay_constant, resolution),
+        diffusion_coeff_(diffusion_coeff), threshold_(threshold) {}
+
+    void DiffuseWithClosedEdge(real_t dt) override { Solve(dt, StencilEdge::kMirror); }
+    void DiffuseWithNeumann(real_t dt) override { Solve(dt, StencilEdge::kMirror); }
+    void DiffuseWithOpenEdge(real_t dt) override { Solve(dt, StencilEdge::kZero); }
+    void DiffuseWithPeriodic(real_t dt) override { Solve(dt, StencilEdge::kPeriodic); }
+    void DiffuseWithDirichlet(real_t dt) override {
+      Solve(dt, StencilEdge::kFixed);
+      SetDirichletBoundary(*this, GetSimulatedTime(), &c1_);
+    }
+
+    // fraction of the lattice updated by the last time step
+    real_t GetActiveFraction() const {
+      return active_blocks_.size() / std::max<real_t>(block_max_.size(), 1);
+    }
+
+  private:
+    void Solve(real_t dt, StencilEdge edge) {
+      const size_t n = resolution_;
+      const size_t nb = (n + kBlock - 1) / kBlock;
+      if (block_max_.size() != nb * nb * nb) {
+        // (re)started: every block is swept by the first time step
+        block_max_.assign(nb * nb * nb, std::numeric_limits<real_t>::max());
+        active_.assign(nb * nb * nb, 0);
+        was_active_.assign(nb * nb * nb, 1);
+        zeros_.assign(n, 0.0);
+        voxels_.Clear();
+      }
+      SelectActiveBlocks(nb, edge);
+
+      WithStencilEdge(edge, [&](auto tag) {
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < active_blocks_.size(); ++i) {
+          SweepBlock<decltype(tag)::value>(active_blocks_[i], nb, dt);
+        }
+      });
+      c1_.swap(c2_);
+      std::swap(active_, was_active_);
+    }
+
+    void SelectActiveBlocks(size_t nb, StencilEdge edge) {
+      const size_t n = resolution_;
+      const size_t num_blocks = nb * nb * nb;
+      // the concentration changed by the agents since the last time step
+      voxels_.Update(*this);
+      for (size_t i : voxels_.NowOrBefore()) {
+        const size_t x = i % n, y = (i / n) % n, z = i / (n * n);
+        real_t& max = block_max_[x / kBlock + nb * (y / kBlock + nb * (z / kBlock))];
+        max = std::max(max, std::abs(c1_[i]));
+      }
+      for (size_t b = 0; b < num_blocks; ++b) active_[b] = block_max_[b] > threshold_;
+      // the neighbors of the blocks above (along the axes, across the
+      // boundaries if periodic), and the faces of the lattice if fixed
+      std::vector<char> seeds(active_);
+      const bool wrap = edge == StencilEdge::kPeriodic;
+      auto seed = [&](size_t bx, size_t by, size_t bz) {
+        return seeds[bx + nb * (by + nb * bz)] != 0;
+      };
+      // seed next to block coordinate k along an axis (false if none)
+      auto next = [&](size_t k, bool up, auto at) {
+        if (up ? k + 1 < nb : k > 0) return at(up ? k + 1 : k - 1);
+        return wrap && at(up ? 0 : nb - 1);
+      };
+      active_blocks_.clear();
+      for (size_t bz = 0; bz < nb; ++bz) {
+        for (size_t by = 0; by < nb; ++by) {
+          for (size_t bx = 0; bx < nb; ++bx) {
+            const size_t b = bx + nb * (by + nb * bz);
+            auto along_x = [&](size_t k) { return seed(k, by, bz); };
+            auto along_y = [&](size_t k) { return seed(bx, k, bz); };
+            auto along_z = [&](size_t k) { return seed(bx, by, k); };
+            bool active = seeds[b] || next(bx, false, along_x) || next(bx, true, along_x) ||
+                          next(by, false, along_y) || next(by, true, along_y) ||
+                          next(bz, false, along_z) || next(bz, true, along_z);
+            if (edge == StencilEdge::kFixed) {
+              active = active || bx == 0 || by == 0 || bz == 0 ||
+                       bx == nb - 1 || by == nb - 1 || bz == nb - 1;
+            }
+            active_[b] = active;
+            if (active) {
+              active_blocks_.push_back(b);
+            } else if (was_active_[b]) {
+              // both arrays hold the (unchanged) concentration of an
+              // inactive block
+              CopyBlock(b, nb);
+            }
+          }
+        }
+      }
+      // the (negligible) changes of the agents to the blocks left inactive
+      for (size_t i : voxels_.NowOrBefore()) {
+        const size_t x = i % n, y = (i / n) % n, z = i / (n * n);
+        if (!active_[x / kBlock + nb * (y / kBlock + nb * (z / kBlock))]) c2_[i] = c1_[i];
+      }
+    }
+
+    template <typename F>
+    void ForEachRow(size_t b, size_t nb, F f) const {
+      const size_t n = resolution_;
+      const size_t x0 = (b % nb) * kBlock;
+      const size_t y0 = ((b / nb) % nb) * kBlock;
+      const size_t z0 = (b / (nb * nb)) * kBlock;
+      const size_t x1 = std::min(x0 + kBlock, n);
+      for (size_t z = z0; z < std::min(z0 + kBlock, n); ++z) {
+        for (size_t y = y0; y < std::min(y0 + kBlock, n); ++y) f(y, z, x0, x1);
+      }
+    }
+
+    void CopyBlock(size_t b, size_t nb) {
+      const size_t n = resolution_;
+      real_t max = 0.0;
+      ForEachRow(b, nb, [&](size_t y, size_t z, size_t x0, size_t x1) {
+        const size_t row = n * (y + n * z);
+        std::copy(c1_.data() + row + x0, c1_.data() + row + x1, c2_.data() + row + x0);
+        for (size_t x = x0; x < x1; ++x) max = std::max(max, std::abs(c1_[row + x]));
+      });
+      block_max_[b] = max;
+    }
+
+    template <StencilEdge kEdge>
+    void SweepBlock(size_t b, size_t nb, real_t dt) {
+      const size_t n = resolution_;
+      const size_t nn = n * n;
+      const real_t r = diffusion_coeff_ * dt / (box_length_ * box_length_);
+      const real_t keep = 1.0 - mu_ * dt;
+      const real_t* u = c1_.data();
+      real_t* v = c2_.data();
+      const real_t* zeros = zeros_.data();
+      real_t max = 0.0;
+      ForEachRow(b, nb, [&](size_t y, size_t z, size_t x0, size_t x1) {
+        const real_t* row = u + n * (y + n * z);
+        real_t* out = v + n * (y + n * z);
+        EulerStencilRow<kEdge>(n, x0, x1, r, keep, row,
+                               StencilNeighbor<kEdge>(row, y, false, n, n, zeros),
+                               StencilNeighbor<kEdge>(row, y, true, n, n, zeros),
+                               StencilNeighbor<kEdge>(row, z, false, nn, n, zeros),
+                               StencilNeighbor<kEdge>(row, z, true, nn, n, zeros), out);
+        for (size_t x = x0; x < x1; ++x) max = std::max(max, std::abs(out[x]));
+      });
+      block_max_[b] = max;
+    }
+
+    real_t diffusion_coeff_ = 0.0;
+    real_t threshold_ = 1e-9;
+    // maximum concentration of every block after its last update, raised
+    // by the agents since
+    std::vector<real_t> block_max_;
+    AgentVoxels voxels_;
+    // whether every block is updated by the current/previous time step
+    std::vector<char> active_, was_active_;
+    std::vector<size_t> active_blocks_;
+    std::vector<real_t> zeros_;
+
+    BDM_CLASS_DEF_OVERRIDE(SparseGrid, 1);
+};
+
+} // namespace bdm
+
+#endif // SPARSE_GRID_H_
@@ -0,0 +1,251 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef STEADY_STATE_H_
+#define STEADY_STATE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+#include "counter_random.h"
+#include "dirichlet_boundary.h"
+#include "stencil.h"
+#include "substances.h"
+
+namespace bdm {
+
+/*
+Solver of the steady state of the concentration of a substance, i.e., of
+  D * laplacian(c) - decay_constant * c + s = 0
+with the 7-point finite difference stencil of the simulation engine on the
+lattice of the substance and its boundary conditions, where the source s of
+every voxel is the quantity secreted (negative if taken up) by its agents
+per unit of time. The discrete steady state is a fixed point of the
+explicit time steps of the engine, hence replacing the concentration by it
+(once, or every 'interval' time steps as the agents move) spares the
+thousands of time steps that the explicit solver takes to reach it.
+The linear system is solved by conjugate gradients. With zero-flux (closed
+or Neumann) or periodic boundaries and no decay, the steady state exists
+only for a zero net source, and it is then the one of the same mean
+concentration. If the net source is not negligible (e.g. the uptake of
+example "ex10" outweighs its secretion), the explicit solver never settles:
+the concentration is left to it, and a warning is logged.
+The steady state is not clamped, i.e., a sink that takes up more than it
+receives yields negative concentrations, as the explicit solver does, and
+it is written to the lattice as it is (see 'SetConcentrations').
+Usage:
+  auto* steady_state = new SteadyState("TGF", [](const Agent* agent) {
+    return ...;  // quantity per time step, as for 'Secretion'
+  }, 100);
+  steady_state->Install(sim.GetScheduler());
+*/
+class SteadyState : public StandaloneOperationImpl {
+  BDM_OP_HEADER(SteadyState);
+
+  public:
+    // quantity secreted by an agent every time step (negative for uptake)
+    using Quantity = std::function<real_t(const Agent*)>;
+
+    SteadyState() = default;
+    SteadyState(const std::string& substance, const Quantity& quantity, uint64_t interval,
+                real_t tolerance = 1e-8, uint64_t max_iterations = 10000)
+      : substance_(substance), quantity_(quantity),
+        interval_(std::max<uint64_t>(interval, 1)), tolerance_(tolerance),
+        max_iterations_(max_iterations) {}
+
+    // schedules the solver after the first time step and every 'interval'
+    // time steps after it
+    void Install(Scheduler* scheduler) {
+      auto* op = new Operation("steady state");
+      op->AddOperationImpl(kCpu, this);
+      scheduler->ScheduleOp(op, OpType::kPostSchedule);
+    }
+
+    void operator()() override {
+      const uint64_t step = CounterRandom::GetStep(Simulation::GetActive());
+      if (step % interval_ == 0) Solve();
+    }
+
+    // replaces the concentration of the substance by its steady state
+    void Solve() {
+      auto* sim = Simulation::GetActive();
+      auto* rm = sim->GetResourceManager();
+      // https://biodynamo.github.io/api/classbdm_1_1DiffusionGrid.html
+      auto* grid = rm->GetDiffusionGrid(substance_);
+      n_ = grid->GetResolution();
+      const size_t num_voxels = n_ * n_ * n_;
+      const real_t h = grid->GetBoxLength();
+      // the engine stores the coefficient divided by the six neighbors
+      diffusion_ = 6.0 * grid->GetDiffusionCoefficients()[1] / (h * h);
+      decay_ = grid->GetDecayConstant();
+      edge_ = GetStencilEdge(grid->GetBoundaryConditionType());
+      const bool singular = decay_ == 0.0 && edge_ != StencilEdge::kZero &&
+                            edge_ != StencilEdge::kFixed;
+
+      SynchronizeConcentration(grid);
+      const real_t* c = grid->GetAllConcentrations();
+      x_.assign(c, c + num_voxels);
+      r_.assign(num_voxels, 0.0);
+      const real_t dt = sim->GetParam()->simulation_time_step;
+      rm->ForEachAgent([&](Agent* agent) {
+        r_[grid->GetBoxIndex(agent->GetPosition())] += quantity_(agent) / dt;
+      });
+      fixed_.assign(edge_ == StencilEdge::kFixed ? num_voxels : 0, 0);
+      if (edge_ == StencilEdge::kFixed) {
+        SetDirichletBoundary(*grid, grid->GetSimulatedTime(), &x_);
+        for (size_t i = 0; i < num_voxels; ++i) {
+          const size_t x = i % n_, y = (i / n_) % n_, z = i / (n_ * n_);
+          fixed_[i] = x == 0 || y == 0 || z == 0 || x == n_ - 1 || y == n_ - 1 || z == n_ - 1;
+          if (fixed_[i]) r_[i] = 0.0;
+        }
+      }
+      if (singular) {
+        real_t net = 0.0, total = 0.0;
+        for (real_t s : r_) {
+          net += s;
+          total += std::abs(s);
+        }
+        if (std::abs(net) > kNetSourceTolerance * total) {
+          Log::Warning("SteadyState::Solve", "substance ", substance_, " has a net source of ",
+                       net, " per unit of time without decay and within zero-flux boundaries,",
+                       " hence no steady state: the concentration is left to the time steps");
+          iterations_ = 0;
+          residual_ = 0.0;
+          return;
+        }
+        // (the round-off of the sum of the sources)
+        Center(&r_);
+      }
+      const real_t reference = std::sqrt(Dot(r_, r_));
+
+      // residual r = s - A x, where A = -D * laplacian + decay_constant
+      p_.resize(num_voxels);
+      q_.resize(num_voxels);
+      zeros_.assign(n_, 0.0);
+      Apply(x_, &q_);
+#pragma omp parallel for simd schedule(static)
+      for (size_t i = 0; i < num_voxels; ++i) r_[i] -= q_[i];
+      if (singular) Center(&r_);
+
+      p_ = r_;
+      real_t rr = Dot(r_, r_);
+      const real_t tolerance = tolerance_ * (reference > 0.0 ? reference : std::sqrt(rr));
+      iterations_ = 0;
+      while (std::sqrt(rr) > tolerance && iterations_ < max_iterations_) {
+        Apply(p_, &q_);
+        const real_t alpha = rr / Dot(p_, q_);
+#pragma omp parallel for simd schedule(static)
+        for (size_t i = 0; i < num_voxels; ++i) {
+          x_[i] += alpha * p_[i];
+          r_[i] -= alpha * q_[i];
+        }
+        // (the round-off errors would accumulate in the null space)
+        if (singular) Center(&r_);
+        const real_t rr_next = Dot(r_, r_);
+        const real_t beta = rr_next / rr;
+        rr = rr_next;
+#pragma omp parallel for simd schedule(static)
+        for (size_t i = 0; i < num_voxels; ++i) p_[i] = r_[i] + beta * p_[i];
+        ++iterations_;
+      }
+      residual_ = reference > 0.0 ? std::sqrt(rr) / reference : 0.0;
+
+      SetConcentrations(grid, x_.data());
+    }
+
+    // iterations and relative residual of the last solve
+    uint64_t GetIterations() const { return iterations_; }
+    real_t GetResidual() const { return residual_; }
+
+  private:
+    // largest net source (relative to the sum of the absolute sources) of a
+    // singular system that is taken as round-off
+    static constexpr real_t kNetSourceTolerance = 1e-6;
+
+    // q = A p, zero on the fixed voxels, whose p is taken as zero
+    void Apply(const std::vector<real_t>& p, std::vector<real_t>* q) {
+      WithStencilEdge(edge_, [&](auto tag) { Apply<decltype(tag)::value>(p, q); });
+      if (edge_ == StencilEdge::kFixed) {
+        // the boundary voxels are known: their rows are dropped, and their
+        // columns are moved to the right hand side by the initial residual
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < p.size(); ++i) {
+          if (fixed_[i]) (*q)[i] = 0.0;
+        }
+      }
+    }
+
+    template <StencilEdge kEdge>
+    void Apply(const std::vector<real_t>& p, std::vector<real_t>* q) {
+      const size_t n = n_;
+      const size_t nn = n * n;
+#pragma omp parallel for collapse(2) schedule(static)
+      for (size_t z = 0; z < n; ++z) {
+        for (size_t y = 0; y < n; ++y) {
+          const real_t* row = p.data() + n * (y + n * z);
+          const real_t* zeros = zeros_.data();
+          const real_t* south = StencilNeighbor<kEdge>(row, y, false, n, n, zeros);
+          const real_t* north = StencilNeighbor<kEdge>(row, y, true, n, n, zeros);
+          const real_t* bottom = StencilNeighbor<kEdge>(row, z, false, nn, n, zeros);
+          const real_t* top = StencilNeighbor<kEdge>(row, z, true, nn, n, zeros);
+          real_t* out = q->data() + n * (y + n * z);
+          for (size_t x = 0; x < n; ++x) {
+            const real_t west = x > 0 ? row[x - 1] : StencilOutside<kEdge>(row, x, n);
+            const real_t east = x + 1 < n ? row[x + 1] : StencilOutside<kEdge>(row, x, n);
+            out[x] = diffusion_ *
+                         (6.0 * row[x] - west - east - south[x] - north[x] - bottom[x] - top[x]) +
+                     decay_ * row[x];
+          }
+        }
+      }
+    }
+
+    real_t Dot(const std::vector<real_t>& a, const std::vector<real_t>& b) const {
+      real_t sum = 0.0;
+#pragma omp parallel for simd schedule(static) reduction(+:sum)
+      for (size_t i = 0; i < a.size(); ++i) sum += a[i] * b[i];
+      return sum;
+    }
+
+    static void Center(std::vector<real_t>* v) {
+      real_t sum = 0.0;
+#pragma omp parallel for simd schedule(static) reduction(+:sum)
+      for (size_t i = 0; i < v->size(); ++i) sum += (*v)[i];
+      const real_t mean = sum / v->size();
+#pragma omp parallel for simd schedule(static)
+      for (size_t i = 0; i < v->size(); ++i) (*v)[i] -= mean;
+    }
+
+    std::string substance_;
+    Quantity quantity_;
+    uint64_t interval_ = 1;
+    real_t tolerance_ = 1e-8;
+    uint64_t max_iterations_ = 10000;
+    uint64_t iterations_ = 0;
+    real_t residual_ = 0.0;
+    // the linear system of the last solve
+    size_t n_ = 0;
+    real_t diffusion_ = 0.0, decay_ = 0.0;
+    StencilEdge edge_ = StencilEdge::kMirror;
+    std::vector<real_t> x_, r_, p_, q_, zeros_;
+    std::vector<char> fixed_;
+};
+
+} // namespace bdm
+
+#endif // STEADY_STATE_H_
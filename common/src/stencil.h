@@ -0,0 +1,172 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef STENCIL_H_
+#define STENCIL_H_
+
+#include <cstddef>
+#include <type_traits>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+Building blocks of the 7-point finite difference stencil over the lattice of
+a substance (n voxels along each dimension, x being contiguous), shared by
+the solvers of the 'common/src' folder.
+
+Concentration outside the lattice: the same as on the boundary (zero flux,
+as for closed and Neumann boundaries, and for Dirichlet ones whose boundary
+voxels are then reset), zero (open boundaries), or the one on the opposite
+boundary (periodic boundaries).
+*/
+enum class StencilEdge { kMirror, kZero, kPeriodic, kFixed };
+
+inline StencilEdge GetStencilEdge(BoundaryConditionType type) {
+  switch (type) {
+    case BoundaryConditionType::kOpenBoundaries: return StencilEdge::kZero;
+    case BoundaryConditionType::kPeriodic: return StencilEdge::kPeriodic;
+    case BoundaryConditionType::kDirichlet: return StencilEdge::kFixed;
+    default: return StencilEdge::kMirror;
+  }
+}
+
+/*
+The kernels below are specialized on the edge at compile time (the template
+parameter kEdge), so that they carry no branch on it; 'WithStencilEdge'
+picks the specialization once per sweep, e.g.:
+  WithStencilEdge(edge, [&](auto tag) {
+    constexpr StencilEdge kEdge = decltype(tag)::value;
+    ... EulerStencilRow<kEdge>(...) ...
+  });
+Fixed (Dirichlet) edges are swept as zero flux, their boundary voxels being
+reset afterwards (see the 'dirichlet_boundary.h' header file).
+*/
+template <StencilEdge kEdge>
+using StencilEdgeTag = std::integral_constant<StencilEdge, kEdge>;
+
+template <typename F>
+inline void WithStencilEdge(StencilEdge edge, F&& f) {
+  switch (edge) {
+    case StencilEdge::kZero: f(StencilEdgeTag<StencilEdge::kZero>()); break;
+    case StencilEdge::kPeriodic: f(StencilEdgeTag<StencilEdge::kPeriodic>()); break;
+    default: f(StencilEdgeTag<StencilEdge::kMirror>()); break;
+  }
+}
+
+/*
+The row of voxels next to a row, along 'stride' (n for y, n*n for z), given
+the coordinate k of the row along that axis; outside the lattice, the row
+itself, a row of n zeros or the row on the opposite boundary.
+*/
+template <StencilEdge kEdge, typename T>
+inline const T* StencilNeighbor(const T* row, size_t k, bool up, size_t stride, size_t n,
+                                const T* zeros) {
+  if (up ? k + 1 < n : k > 0) return up ? row + stride : row - stride;
+  if constexpr (kEdge == StencilEdge::kZero) {
+    return zeros;
+  } else if constexpr (kEdge == StencilEdge::kPeriodic) {
+    return up ? row - (n - 1) * stride : row + (n - 1) * stride;
+  } else {
+    return row;
+  }
+}
+
+// the concentration outside the lattice next to voxel x (0 or n-1) of a row
+// with k interleaved values per voxel (see 'InterleavedEulerStencilRow')
+template <StencilEdge kEdge, typename T>
+inline real_t StencilOutside(const T* row, size_t x, size_t n, size_t k = 1) {
+  if constexpr (kEdge == StencilEdge::kZero) {
+    return 0.0;
+  } else if constexpr (kEdge == StencilEdge::kPeriodic) {
+    return row[(x == 0 ? n - 1 : 0) * k];
+  } else {
+    return row[x * k];
+  }
+}
+
+/*
+Explicit (Euler) time step of the voxels [x0, x1) of a row, as the
+simulation engine computes it:
+  out = keep * c + r * (sum of the six neighbors - 6 * c)
+with keep = 1 - decay_constant * dt and r = D * dt / h^2. The inner voxels
+are updated by a loop without branches, which is vectorized. The voxels may
+be stored in a narrower type T than real_t (e.g. float, see the
+'mixed_precision_grid.h' header file), the update is computed in real_t.
+*/
+template <StencilEdge kEdge, typename T>
+inline void EulerStencilRow(size_t n, size_t x0, size_t x1, real_t r, real_t keep,
+                            const T* __restrict row, const T* __restrict south,
+                            const T* __restrict north, const T* __restrict bottom,
+                            const T* __restrict top, T* __restrict out) {
+  auto update = [&](size_t x, real_t west, real_t east) {
+    out[x] = static_cast<T>(
+        keep * row[x] +
+        r * (west + east + south[x] + north[x] + bottom[x] + top[x] - 6.0 * row[x]));
+  };
+  const size_t begin = x0 > 0 ? x0 : 1;
+  const size_t end = x1 < n - 1 ? x1 : n - 1;
+  if (x0 == 0) {
+    const real_t west = StencilOutside<kEdge>(row, 0, n);
+    update(0, west, n > 1 ? real_t(row[1]) : StencilOutside<kEdge>(row, n - 1, n));
+  }
+#pragma omp simd
+  for (size_t x = begin; x < end; ++x) {
+    const real_t c = row[x];
+    out[x] = static_cast<T>(keep * c + r * (real_t(row[x - 1]) + row[x + 1] + south[x] +
+                                            north[x] + bottom[x] + top[x] - 6.0 * c));
+  }
+  if (x1 == n && n > 1) update(n - 1, row[n - 2], StencilOutside<kEdge>(row, n - 1, n));
+}
+
+/*
+The same time step for a row of n voxels holding k substances each, stored
+interleaved (the k concentrations of voxel x at x * k to x * k + k - 1), as
+one row of n * k values whose neighbors along x are k values apart; r and
+keep are the coefficients of every value of a row (the k coefficients of
+the substances repeated n times), so that the inner loop over all values of
+the row is without branches, hence vectorized.
+*/
+template <StencilEdge kEdge>
+inline void InterleavedEulerStencilRow(size_t n, size_t k, const real_t* __restrict r,
+                                       const real_t* __restrict keep,
+                                       const real_t* __restrict row,
+                                       const real_t* __restrict south,
+                                       const real_t* __restrict north,
+                                       const real_t* __restrict bottom,
+                                       const real_t* __restrict top, real_t* __restrict out) {
+  auto update = [&](size_t j, real_t west, real_t east) {
+    out[j] = keep[j] * row[j] +
+             r[j] * (west + east + south[j] + north[j] + bottom[j] + top[j] - 6.0 * row[j]);
+  };
+  const size_t end = (n - 1) * k;
+  for (size_t s = 0; s < k; ++s) {
+    const real_t west = StencilOutside<kEdge>(row + s, 0, n, k);
+    update(s, west, n > 1 ? row[k + s] : StencilOutside<kEdge>(row + s, n - 1, n, k));
+  }
+#pragma omp simd
+  for (size_t j = k; j < end; ++j) {
+    out[j] = keep[j] * row[j] + r[j] * (row[j - k] + row[j + k] + south[j] + north[j] +
+                                        bottom[j] + top[j] - 6.0 * row[j]);
+  }
+  if (n > 1) {
+    for (size_t s = 0; s < k; ++s) {
+      update(end + s, row[end - k + s], StencilOutside<kEdge>(row + s, n - 1, n, k));
+    }
+  }
+}
+
+} // namespace bdm
+
+#endif // STENCIL_H_
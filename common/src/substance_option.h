@@ -0,0 +1,61 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef SUBSTANCE_OPTION_H_
+#define SUBSTANCE_OPTION_H_
+
+#include <string>
+
+#include "biodynamo.h"
+#include "scenario.h"
+#include "substances.h"
+
+namespace bdm {
+
+/*
+Option of the scenario (see the 'scenario.h' header file) that selects how
+the substances defined by the 'DefineSubstance' function are solved (see
+the 'substances.h' header file):
+  --diffusion-method
+             overrides the solver of the substances: "euler", "adi",
+             "sparse" or "fused"
+  --substance-precision
+             storage of the diffusing substances for "euler": "double" or
+             "float" (see the 'mixed_precision_grid.h' header file), to be
+             passed to 'DefineSubstance' through 'GetSubstancePrecision'
+*/
+class SubstanceOption : public ScenarioOption {
+  public:
+    explicit SubstanceOption(CommandLineOptions* clo) {
+      clo->AddOption<std::string>("diffusion-method", "", "Solver of the substances: euler, adi, sparse or fused (empty keeps the default of the example)");
+      clo->AddOption<std::string>("substance-precision", "double", "Storage of the diffusing substances: double or float");
+    }
+
+    void Apply(const Scenario&, CommandLineOptions* clo, Param* param) override {
+      const auto method = clo->Get<std::string>("diffusion-method");
+      if (!method.empty()) param->diffusion_method = method;
+      float_substances_ = clo->Get<std::string>("substance-precision") == "float";
+    }
+
+    // storage of the substances to pass to 'DefineSubstance'
+    SubstancePrecision GetSubstancePrecision() const {
+      return float_substances_ ? SubstancePrecision::kFloat : SubstancePrecision::kFull;
+    }
+
+  private:
+    bool float_substances_ = false;
+};
+
+} // namespace bdm
+
+#endif // SUBSTANCE_OPTION_H_
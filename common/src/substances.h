@@ -0,0 +1,107 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef SUBSTANCES_H_
+#define SUBSTANCES_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+#include "adi_grid.h"
+#include "decay_grid.h"
+#include "fused_substance_grid.h"
+#include "mixed_precision_grid.h"
+#include "sparse_grid.h"
+#include "tiled_euler_grid.h"
+
+namespace bdm {
+
+/*
+Same as 'ModelInitializer::DefineSubstance', except that the solver of the
+substance is chosen by 'param->diffusion_method': "adi" for an 'AdiGrid'
+(stable for any time step, see example "ex10"), "sparse" for a 'SparseGrid'
+(which updates only the region where the substance is present), "fused"
+for a 'FusedSubstanceGrid' (swept together with the other substances of the
+same resolution) if the substance diffuses, otherwise
+a substance with a zero diffusion coefficient is solved by a 'DecayGrid'
+instead of a finite difference stencil over its lattice (see examples "ex8"
+and "ex9"), and a diffusing one by the 'TiledEulerGrid' for "euler" (the
+other methods of the simulation engine are left to it). For "euler", a
+diffusing substance of 'SubstancePrecision::kFloat' is stored in a
+'MixedPrecisionGrid' instead (see example "ex10", '--substance-precision').
+*/
+inline void DefineSubstance(int substance_id, const std::string& substance_name,
+                            real_t diffusion_coeff, real_t decay_constant, int resolution = 10,
+                            SubstancePrecision precision = SubstancePrecision::kFull) {
+  auto* sim = Simulation::GetActive();
+  // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
+  auto* rm = sim->GetResourceManager();
+  if (sim->GetParam()->diffusion_method == "adi") {
+    rm->AddContinuum(
+        new AdiGrid(substance_id, substance_name, diffusion_coeff, decay_constant, resolution));
+  } else if (sim->GetParam()->diffusion_method == "sparse") {
+    rm->AddContinuum(
+        new SparseGrid(substance_id, substance_name, diffusion_coeff, decay_constant, resolution));
+  } else if (diffusion_coeff == 0.0) {
+    rm->AddContinuum(new DecayGrid(substance_id, substance_name, decay_constant, resolution));
+  } else if (sim->GetParam()->diffusion_method == "fused") {
+    rm->AddContinuum(new FusedSubstanceGrid(substance_id, substance_name, diffusion_coeff,
+                                            decay_constant, resolution));
+  } else if (sim->GetParam()->diffusion_method == "euler" &&
+             precision == SubstancePrecision::kFloat) {
+    rm->AddContinuum(new MixedPrecisionGrid(substance_id, substance_name, diffusion_coeff,
+                                            decay_constant, resolution));
+  } else if (sim->GetParam()->diffusion_method == "euler") {
+    rm->AddContinuum(new TiledEulerGrid(substance_id, substance_name, diffusion_coeff,
+                                        decay_constant, resolution));
+  } else {
+    // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
+    ModelInitializer::DefineSubstance(substance_id, substance_name, diffusion_coeff,
+                                      decay_constant, resolution);
+  }
+}
+
+/*
+Brings the concentration of a substance seen by the agents (and the
+simulation engine) up to date on the whole lattice, for the lattices that
+keep it up to date only at the voxels of the agents between time steps
+('MixedPrecisionGrid' and 'FusedSubstanceGrid').
+*/
+inline void SynchronizeConcentration(DiffusionGrid* grid) {
+  if (auto* mixed = dynamic_cast<MixedPrecisionGrid*>(grid)) mixed->Synchronize();
+  if (auto* fused = dynamic_cast<FusedSubstanceGrid*>(grid)) fused->Synchronize();
+}
+
+/*
+Overwrites the concentration of a substance on the whole lattice with the
+given values, as they are: unlike 'ChangeConcentrationBy' it neither adds
+to the concentration (with its round-off) nor clamps it to the thresholds
+of the grid. The lattices that keep the concentration seen by the agents
+up to date only at their voxels take the new values over as well.
+*/
+inline void SetConcentrations(DiffusionGrid* grid, const real_t* values) {
+  // the lattice is protected, but may be named through a subclass
+  struct Lattice : public DiffusionGrid {
+    static std::vector<real_t>& Of(DiffusionGrid* grid) { return grid->*(&Lattice::c1_); }
+  };
+  SynchronizeConcentration(grid);
+  std::vector<real_t>& c = Lattice::Of(grid);
+  std::copy(values, values + c.size(), c.begin());
+  SynchronizeConcentration(grid);
+}
+
+} // namespace bdm
+
+#endif // SUBSTANCES_H_
@@ -0,0 +1,120 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef TILED_EULER_GRID_H_
+#define TILED_EULER_GRID_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+#include "dirichlet_boundary.h"
+#include "stencil.h"
+
+namespace bdm {
+
+/*
+Lattice of a substance solved by the same explicit finite differences as
+the "euler" method of the simulation engine, with a kernel that is limited
+by the memory bandwidth rather than by index arithmetic: the lattice is
+split into tiles of 8 rows (along y) times 32 planes (along z), processed in
+parallel, so that the three planes of rows of a tile that the stencil reads
+stay in the cache while a tile streams along z, and every row is updated by
+a vectorized loop over its (contiguous) voxels (see 'stencil.h').
+Picked by 'DefineSubstance' for 'param->diffusion_method = "euler"' (see the
+'substances.h' header file); Neumann boundaries are zero flux.
+*/
+class TiledEulerGrid : public DiffusionGrid {
+  public:
+    static constexpr size_t kTileY = 8;
+    static constexpr size_t kTileZ = 32;
+
+    TiledEulerGrid() = default;
+    TiledEulerGrid(int substance_id, const std::string& substance_name, real_t diffusion_coeff,
+                   real_t decay_constant, int resolution = 10)
+      : DiffusionGrid(substance_id, substance_name, diffusion_coeff, decay_constant, resolution),
+        diffusion_coeff_(diffusion_coeff) {}
+
+    void DiffuseWithClosedEdge(real_t dt) override { Solve(dt, StencilEdge::kMirror); }
+    void DiffuseWithNeumann(real_t dt) override { Solve(dt, StencilEdge::kMirror); }
+    void DiffuseWithOpenEdge(real_t dt) override { Solve(dt, StencilEdge::kZero); }
+    void DiffuseWithPeriodic(real_t dt) override { Solve(dt, StencilEdge::kPeriodic); }
+    void DiffuseWithDirichlet(real_t dt) override {
+      Solve(dt, StencilEdge::kMirror);
+      SetDirichletBoundary(*this, GetSimulatedTime(), &c1_);
+    }
+
+    // calls f(y, z) for every row of a lattice of n^3 voxels, tile by tile
+    template <typename F>
+    static void ForEachTileRow(size_t n, F f) {
+      const size_t tiles_y = (n + kTileY - 1) / kTileY;
+      const size_t tiles_z = (n + kTileZ - 1) / kTileZ;
+#pragma omp parallel for collapse(2) schedule(static)
+      for (size_t tz = 0; tz < tiles_z; ++tz) {
+        for (size_t ty = 0; ty < tiles_y; ++ty) {
+          for (size_t z = tz * kTileZ; z < std::min((tz + 1) * kTileZ, n); ++z) {
+            for (size_t y = ty * kTileY; y < std::min((ty + 1) * kTileY, n); ++y) f(y, z);
+          }
+        }
+      }
+    }
+
+    /*
+    One time step of the tiled kernel from the lattice u into v, whose voxels
+    may be stored in a narrower type than real_t (see the
+    'mixed_precision_grid.h' header file); 'zeros' is a row of n zeros.
+    Specialized on the edge of the lattice at compile time, or picked by
+    the edge given at run time (once per time step).
+    */
+    template <StencilEdge kEdge, typename T>
+    static void Sweep(size_t n, real_t r, real_t keep, const T* u, T* v, const T* zeros) {
+      const size_t nn = n * n;
+      ForEachTileRow(n, [&](size_t y, size_t z) {
+        const T* row = u + n * (y + n * z);
+        EulerStencilRow<kEdge>(n, 0, n, r, keep, row,
+                               StencilNeighbor<kEdge>(row, y, false, n, n, zeros),
+                               StencilNeighbor<kEdge>(row, y, true, n, n, zeros),
+                               StencilNeighbor<kEdge>(row, z, false, nn, n, zeros),
+                               StencilNeighbor<kEdge>(row, z, true, nn, n, zeros),
+                               v + n * (y + n * z));
+      });
+    }
+
+    template <typename T>
+    static void Sweep(size_t n, real_t r, real_t keep, StencilEdge edge, const T* u, T* v,
+                      const T* zeros) {
+      WithStencilEdge(edge, [&](auto tag) {
+        Sweep<decltype(tag)::value>(n, r, keep, u, v, zeros);
+      });
+    }
+
+  private:
+    void Solve(real_t dt, StencilEdge edge) {
+      const size_t n = resolution_;
+      const real_t r = diffusion_coeff_ * dt / (box_length_ * box_length_);
+      const real_t keep = 1.0 - mu_ * dt;
+      zeros_.resize(n, 0.0);
+      Sweep<real_t>(n, r, keep, edge, c1_.data(), c2_.data(), zeros_.data());
+      c1_.swap(c2_);
+    }
+
+    real_t diffusion_coeff_ = 0.0;
+    std::vector<real_t> zeros_;
+
+    BDM_CLASS_DEF_OVERRIDE(TiledEulerGrid, 1);
+};
+
+} // namespace bdm
+
+#endif // TILED_EULER_GRID_H_
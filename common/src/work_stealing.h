@@ -0,0 +1,309 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef WORK_STEALING_H_
+#define WORK_STEALING_H_
+
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "biodynamo.h"
+
+namespace bdm {
+
+/*
+The chunks of work of a loop distributed among the threads for work
+stealing: every thread owns a contiguous range of chunks, which it takes
+from the front, while the threads that ran out of work steal from the back
+of the ranges of the others. Both ends of a range are kept in a single
+atomic word, hence a chunk is taken by exactly one thread.
+*/
+class StealingRanges {
+  public:
+    explicit StealingRanges(int threads = 1)
+      : threads_(threads), ranges_(std::make_unique<Range[]>(threads)) {}
+
+    int GetNumThreads() const { return threads_; }
+
+    // the chunks [begin, end) of the given thread
+    void Assign(int thread, uint32_t begin, uint32_t end) {
+      ranges_[thread].bits.store(Pack(begin, end), std::memory_order_relaxed);
+    }
+
+    // takes the next chunk of the own range of the thread
+    bool Next(int thread, uint32_t* chunk) {
+      auto& bits = ranges_[thread].bits;
+      uint64_t old = bits.load(std::memory_order_relaxed);
+      while (Begin(old) < End(old)) {
+        if (bits.compare_exchange_weak(old, Pack(Begin(old) + 1, End(old)))) {
+          *chunk = Begin(old);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // takes the last chunk of the range of another thread, if any is left
+    bool Steal(int thread, uint32_t* chunk) {
+      for (int i = 1; i < threads_; ++i) {
+        auto& bits = ranges_[(thread + i) % threads_].bits;
+        uint64_t old = bits.load(std::memory_order_relaxed);
+        while (Begin(old) < End(old)) {
+          if (bits.compare_exchange_weak(old, Pack(Begin(old), End(old) - 1))) {
+            *chunk = End(old) - 1;
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+  private:
+    // on a cache line of its own, i.e., no false sharing among the threads
+    struct alignas(64) Range {
+      std::atomic<uint64_t> bits{0};
+    };
+
+    static uint64_t Pack(uint32_t begin, uint32_t end) {
+      return (static_cast<uint64_t>(begin) << 32) | end;
+    }
+    static uint32_t Begin(uint64_t bits) { return static_cast<uint32_t>(bits >> 32); }
+    static uint32_t End(uint64_t bits) { return static_cast<uint32_t>(bits); }
+
+    int threads_ = 1;
+    std::unique_ptr<Range[]> ranges_;
+};
+
+/*
+Opt-in execution of the agent operations (the behaviors and the mechanical
+forces) by work stealing, for workloads concentrated on a few agents, e.g.
+the divisions at the rim of the colonies of examples "ex04" and "ex05", or
+the growing cluster of phenotype-2 cells of example "ex11". The agents are
+cut into chunks of consecutive agents, whose cost is measured every time
+step; every thread starts with a contiguous range of chunks of about the
+same cost in the last time step (see 'StealingRanges'), and once done it
+steals the chunks left by the others. The agent operations of the
+scheduler are kept, but their implementations are wrapped so that they do
+nothing when the engine runs them, and this operation runs them (through
+the execution context of the engine, as the engine does, between their
+'SetUp' and 'TearDown') before the engine would, skipping the agents
+rejected by the agent filters of the scheduler (e.g. the dormant tier of
+example "ex07"). The engine still walks over all agents afterwards, calling
+the wrapped operations that do nothing: this second pass is the price of
+the work stealing, which 'bench_work_stealing' reports ('engine_pass_ms').
+Enabled by the command line option '--work-stealing' of the examples (see
+the 'scenario.h' header file).
+Usage:
+  auto* stealing = new WorkStealing();
+  stealing->Install(sim.GetScheduler());
+*/
+class WorkStealing : public StandaloneOperationImpl {
+  BDM_OP_HEADER(WorkStealing);
+
+  public:
+    explicit WorkStealing(uint32_t chunk_size = 256)
+      : chunk_size_(std::max<uint32_t>(chunk_size, 1)) {}
+
+    /*
+    Takes over the agent operations of the scheduler and schedules this
+    operation as the last one before every time step.
+    */
+    void Install(Scheduler* scheduler) {
+      for (const auto& name : scheduler->GetListOfScheduledAgentOps()) {
+        for (auto* op : scheduler->GetOps(name)) {
+          // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+          auto*& impl = op->implementations_[kCpu];
+          auto* stolen = new StolenAgentOp(this, static_cast<AgentOperationImpl*>(impl));
+          impl = stolen;
+          ops_.push_back(op);
+          stolen_.push_back(stolen);
+        }
+      }
+      auto* op = new Operation("work stealing");
+      op->AddOperationImpl(kCpu, this);
+      scheduler->ScheduleOp(op, OpType::kPreSchedule);
+    }
+
+    void operator()() override {
+      auto* sim = Simulation::GetActive();
+      auto* rm = sim->GetResourceManager();
+      auto* scheduler = sim->GetScheduler();
+      const uint64_t step = scheduler->GetSimulatedSteps();
+      const auto& filters = scheduler->GetAgentFilters();
+      due_ops_.clear();
+      due_stolen_.clear();
+      for (size_t i = 0; i < ops_.size(); ++i) {
+        if (step % std::max<uint64_t>(ops_[i]->frequency_, 1) == 0) {
+          due_ops_.push_back(ops_[i]);
+          due_stolen_.push_back(stolen_[i]);
+        }
+      }
+
+      // the chunks of the agents of every NUMA domain
+      chunks_.clear();
+      const int numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+      for (int numa = 0; numa < numa_nodes; ++numa) {
+        const uint64_t n = rm->GetNumAgents(numa);
+        for (uint64_t begin = 0; begin < n; begin += chunk_size_) {
+          chunks_.push_back({numa, static_cast<uint32_t>(begin),
+                             static_cast<uint32_t>(std::min<uint64_t>(begin + chunk_size_, n))});
+        }
+      }
+      const int threads = omp_get_max_threads();
+      if (ranges_ == nullptr || ranges_->GetNumThreads() != threads) {
+        ranges_ = std::make_shared<StealingRanges>(threads);
+      }
+      Partition(threads);
+      busy_ns_.assign(threads, 0);
+
+      // the engine sets the operations up only after this (pre-scheduled)
+      // operation, hence their wrappers leave it to this one
+      for (auto* stolen : due_stolen_) stolen->Wrapped()->SetUp();
+      const auto start = std::chrono::steady_clock::now();
+      running_ = true;
+      uint64_t steals = 0;
+#pragma omp parallel reduction(+:steals)
+      {
+        const int thread = omp_get_thread_num();
+        // https://biodynamo.github.io/api/classbdm_1_1InPlaceExecutionContext.html
+        auto* ctxt = sim->GetExecutionContext();
+        uint32_t c;
+        while (true) {
+          if (!ranges_->Next(thread, &c)) {
+            if (!ranges_->Steal(thread, &c)) break;
+            ++steals;
+          }
+          const auto chunk_start = std::chrono::steady_clock::now();
+          const Chunk& chunk = chunks_[c];
+          for (uint32_t i = chunk.begin; i < chunk.end; ++i) {
+            const AgentHandle handle(chunk.numa, i);
+            auto* agent = rm->GetAgent(handle);
+            if (Accepted(filters, agent)) ctxt->Execute(agent, handle, due_ops_);
+          }
+          const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - chunk_start).count();
+          costs_[c] = ns;
+          busy_ns_[thread] += ns;
+        }
+      }
+      running_ = false;
+      const std::chrono::duration<real_t, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      for (auto* stolen : due_stolen_) stolen->Wrapped()->TearDown();
+
+      step_ms_.push_back(elapsed.count());
+      steals_ += steals;
+      const uint64_t busiest = *std::max_element(busy_ns_.begin(), busy_ns_.end());
+      uint64_t total = 0;
+      for (uint64_t ns : busy_ns_) total += ns;
+      imbalance_.push_back(total > 0 ? busiest * threads / static_cast<real_t>(total) : 1.0);
+    }
+
+    // wall time (in milliseconds) of the agent operations of every time step
+    const std::vector<real_t>& GetStepTimes() const { return step_ms_; }
+    // busiest over mean time of the threads of every time step
+    const std::vector<real_t>& GetImbalance() const { return imbalance_; }
+    uint64_t GetNumSteals() const { return steals_; }
+
+  private:
+    struct Chunk {
+      int numa;
+      uint32_t begin, end;
+    };
+
+    static bool Accepted(const std::vector<Functor<bool, Agent*>*>& filters, Agent* agent) {
+      for (auto* filter : filters) {
+        if (!(*filter)(agent)) return false;
+      }
+      return true;
+    }
+
+    /*
+    Cuts the chunks into contiguous ranges of about the same cost in the
+    last time step, one per thread; the chunks beyond those of the last
+    time step (if the agents grew in number) cost their mean.
+    */
+    void Partition(int threads) {
+      const size_t n = chunks_.size();
+      real_t mean = 1.0;
+      if (!costs_.empty()) {
+        uint64_t sum = 0;
+        for (uint64_t ns : costs_) sum += ns;
+        mean = std::max<real_t>(static_cast<real_t>(sum) / costs_.size(), 1.0);
+      }
+      prefix_.resize(n + 1);
+      prefix_[0] = 0.0;
+      for (size_t c = 0; c < n; ++c) {
+        prefix_[c + 1] = prefix_[c] + (c < costs_.size() ? std::max<real_t>(costs_[c], 1.0) : mean);
+      }
+      costs_.assign(n, 0);
+      size_t begin = 0;
+      for (int t = 0; t < threads; ++t) {
+        const real_t target = prefix_[n] * (t + 1) / threads;
+        size_t end = t + 1 == threads ? n : begin;
+        while (end < n && prefix_[end + 1] <= target) ++end;
+        ranges_->Assign(t, static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+        begin = end;
+      }
+    }
+
+    /*
+    An agent operation that only runs when run by the work stealing, which
+    also sets it up and tears it down around its loop (hence not when the
+    engine does).
+    */
+    class StolenAgentOp : public AgentOperationImpl {
+      BDM_OP_HEADER(StolenAgentOp);
+
+      public:
+        StolenAgentOp() = default;
+        StolenAgentOp(WorkStealing* stealing, AgentOperationImpl* impl)
+          : stealing_(stealing), impl_(impl) {}
+
+        void SetUp() override {}
+        void TearDown() override {}
+        void operator()(Agent* agent) override {
+          if (stealing_->running_) (*impl_)(agent);
+        }
+
+        AgentOperationImpl* Wrapped() const { return impl_.get(); }
+
+      private:
+        WorkStealing* stealing_ = nullptr;
+        std::shared_ptr<AgentOperationImpl> impl_;
+    };
+
+    uint32_t chunk_size_ = 256;
+    std::vector<Operation*> ops_, due_ops_;
+    std::vector<StolenAgentOp*> stolen_, due_stolen_;
+    std::vector<Chunk> chunks_;
+    std::shared_ptr<StealingRanges> ranges_;
+    // the cost (in nanoseconds) of every chunk in the last time step
+    std::vector<uint64_t> costs_;
+    std::vector<real_t> prefix_;
+    std::vector<uint64_t> busy_ns_;
+    bool running_ = false;
+    // statistics of every time step
+    std::vector<real_t> step_ms_, imbalance_;
+    uint64_t steals_ = 0;
+};
+
+} // namespace bdm
+
+#endif // WORK_STEALING_H_
@@ -0,0 +1,55 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef WORK_STEALING_OPTION_H_
+#define WORK_STEALING_OPTION_H_
+
+#include "biodynamo.h"
+#include "scenario.h"
+#include "work_stealing.h"
+
+namespace bdm {
+
+/*
+Option of the scenario (see the 'scenario.h' header file) for the divisions
+concentrated at the rim of the colonies (examples "ex04", "ex05" and
+"ex11"):
+  --work-stealing
+             runs the agent operations on chunks of agents balanced by their
+             cost in the last time step, which idle threads steal from the
+             others (see the 'work_stealing.h' header file)
+To be added after the profiler (see the 'profiler_option.h' header file),
+which replaces the implementation of the behaviors.
+*/
+class WorkStealingOption : public ScenarioOption {
+  public:
+    explicit WorkStealingOption(CommandLineOptions* clo) {
+      clo->AddOption<bool>("work-stealing", "false", "Run the agent operations on cost-balanced chunks of agents with work stealing");
+    }
+
+    void Apply(const Scenario&, CommandLineOptions* clo, Param*) override {
+      enabled_ = clo->Get<bool>("work-stealing");
+    }
+
+    void Install(const Scenario&, Simulation* sim, uint64_t*) override {
+      // the scheduler takes over the work stealing operation
+      if (enabled_) (new WorkStealing())->Install(sim->GetScheduler());
+    }
+
+  private:
+    bool enabled_ = false;
+};
+
+} // namespace bdm
+
+#endif // WORK_STEALING_OPTION_H_
@@ -15,10 +15,20 @@
 #define EX01_H_
 
 #include "biodynamo.h"
+#include "scenario.h"
 
 namespace bdm {
 
 inline int ex01(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  Scenario scenario("ex01", &clo);
+
   /*
   User-defined function that can be used to define the global
   parameters of a BioDynaMo simulation, such as the size of the
@@ -27,7 +37,7 @@ inline int ex01(int argc, const char* argv[]) {
   Paraview file, the time increment, etc.
   */
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kOpen;
     param->min_bound =   0.0;
@@ -37,6 +47,7 @@ inline int ex01(int argc, const char* argv[]) {
     param->visualize_agents["Cell"] = { "diameter_" };
     param->statistics = false;
     param->simulation_time_step = 1.0;
+    scenario.Apply(param);
   };
 
   /*
@@ -47,7 +58,7 @@ inline int ex01(int argc, const char* argv[]) {
   above.
   */
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   /*
   Access the data manager, or as it's termed in BioDynaMo, the resource
   manager of the simulation engine.
@@ -61,38 +72,48 @@ inline int ex01(int argc, const char* argv[]) {
   auto* rand = sim.GetRandom();
 
   /*
-  Simply create a 3-component array, i.e., a 3D vector of real-valued
-  data that has been initialized by providing random numbers between
-  45 to 55. This can be thought as a space vector with random numbers
-  in the [45, 55] range.
+  Only one agent is created, unless the model is scaled up (see the
+  command line options above), in which case the cube the agents are
+  created in grows with the simulation domain, so that their density
+  remains.
   */
-  const Real3 xyz{rand->Uniform(45.,55.),
-                  rand->Uniform(45.,55.),
-                  rand->Uniform(45.,55.)};
+  const real_t center = (sim.GetParam()->max_bound + sim.GetParam()->min_bound) / 2;
+  const real_t half_width = scenario.Length(10.0) / 2;
+  for (uint64_t i = 0; i < scenario.Agents(1); ++i) {
+    /*
+    Simply create a 3-component array, i.e., a 3D vector of real-valued
+    data that has been initialized by providing random numbers between
+    45 to 55 (at scale 1). This can be thought as a space vector with
+    random numbers in the [45, 55] range.
+    */
+    const Real3 xyz{rand->Uniform(center-half_width, center+half_width),
+                    rand->Uniform(center-half_width, center+half_width),
+                    rand->Uniform(center-half_width, center+half_width)};
 
-  /*
-  Create an agent, here a BioDynaMo cell that is positioned in 3D
-  space, initially at (0,0,0), the give some value to its diameter
-  and "mass density" and update its position based using the above
-  space vector with random numbers.
-  */
-  // https://biodynamo.github.io/api/classbdm_1_1Cell.html
-  Cell* cell = new Cell({0.0, 0.0, 0.0});
-  cell->SetDiameter(2.0);
-  cell->SetDensity(1.0);
-  cell->SetPosition(xyz);
-  /*
-  An important step to update the resource manager by adding the
-  above agent (i.e., the cell) into the simulation engine.
-  */
-  rm->AddAgent(cell);
+    /*
+    Create an agent, here a BioDynaMo cell that is positioned in 3D
+    space, initially at (0,0,0), the give some value to its diameter
+    and "mass density" and update its position based using the above
+    space vector with random numbers.
+    */
+    // https://biodynamo.github.io/api/classbdm_1_1Cell.html
+    Cell* cell = new Cell({0.0, 0.0, 0.0});
+    cell->SetDiameter(2.0);
+    cell->SetDensity(1.0);
+    cell->SetPosition(xyz);
+    /*
+    An important step to update the resource manager by adding the
+    above agent (i.e., the cell) into the simulation engine.
+    */
+    rm->AddAgent(cell);
+  }
 
   /*
   Ask the BioDynaMo simulation engine to progress for 10 steps,
   where each step separated by the other by an an increment of 1
   (see parameter 'param->simulation_time_step' above).
   */
-  sim.GetScheduler()->Simulate(10);
+  scenario.Simulate(&sim, 10);
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
@@ -15,16 +15,26 @@
 #define EX02_H_
 
 #include "biodynamo.h"
+#include "scenario.h"
 
 namespace bdm {
 
 inline int ex02(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  Scenario scenario("ex02", &clo);
+
   /*
   Same as with the "ex1", yet here we request for BioDynaMo to export
   more data in the Paraview files.
   */
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kClosed;
     param->min_bound =   0.0;
@@ -34,10 +44,11 @@ inline int ex02(int argc, const char* argv[]) {
     param->visualize_agents["Cell"] = { "diameter_", "density_", "volume_" };
     param->statistics = false;
     param->simulation_time_step = 1.0;
+    scenario.Apply(param);
   };
 
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   /*
   Access the global parameters (some are initialized as indicated above)
   of the BioDynaMo simulation engine.
@@ -60,7 +71,7 @@ inline int ex02(int argc, const char* argv[]) {
   Say we wish to create a grid of 5 agents in the X, Y, Z axis
   respectively
   */
-  const size_t agents_per_dim = 5;
+  const size_t agents_per_dim = scenario.PerDim(5);
   /*
   We calculate below the corresponding even spacing among the agents
   */
@@ -73,7 +84,7 @@ inline int ex02(int argc, const char* argv[]) {
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
   ModelInitializer::Grid3D(agents_per_dim,space, generate_grid_of_cells);
 
-  sim.GetScheduler()->Simulate(10);
+  scenario.Simulate(&sim, 10);
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
@@ -15,12 +15,28 @@
 #define EX03_H_
 
 #include "biodynamo.h"
+#include "scenario.h"
+#include "adaptive_parallelism_option.h"
+#include "profiler_option.h"
 
 namespace bdm {
 
 inline int ex03(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  Scenario scenario("ex03", &clo);
+  // the optional features of this example, with their own command line
+  // options (check the header files of the options in 'common/src')
+  scenario.Add<AdaptiveParallelismOption>(&clo);
+  scenario.Add<ProfilerOption>(&clo);
+
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kClosed;
     param->min_bound =   0.0;
@@ -30,10 +46,11 @@ inline int ex03(int argc, const char* argv[]) {
     param->visualize_agents["Cell"] = { "diameter_", "volume_" };
     param->statistics = false;
     param->simulation_time_step = 1.0;
+    scenario.Apply(param);
   };
 
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
   auto* rm = sim.GetResourceManager();
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
@@ -51,34 +68,45 @@ inline int ex03(int argc, const char* argv[]) {
   */
   const real_t mean_xyz((param->max_bound+param->min_bound)/2);
 
-  // https://biodynamo.github.io/api/classbdm_1_1Cell.html
   /*
-  Simply create just one cell.
+  User-defined function utlized below to create a cell at some position.
   */
-  Cell* cell = new Cell({mean_xyz, mean_xyz, mean_xyz});
-  cell->SetDiameter(2.0);
-  cell->SetDensity(1.0);
+  auto create_cell = [&](const Real3& xyz) {
+    // https://biodynamo.github.io/api/classbdm_1_1Cell.html
+    Cell* cell = new Cell(xyz);
+    cell->SetDiameter(2.0);
+    cell->SetDensity(1.0);
+    /*
+    Not only the user can provide value-related data (like diameter,
+    volume, etc.) but also they can plug in the cell "behavior" data.
+    Below, the existing behavior model of growth and division is
+    adopted. By inspection of the BioDynaMo source code, this behavior
+    assumes a cell to grow (by a constant volume rate); when its
+    diameter hits a critical value then it splits and creates a new cell.
+    Notably only the original cell (mother cell) can continue to grow and
+    divide, yet the new cell (daughter cell) simply lives on.
+    */
+    // https://biodynamo.github.io/api/classbdm_1_1GrowthDivision.html
+    cell->AddBehavior(new GrowthDivision(max_diameter, volume_growth_rate));
+    return cell;
+  };
   /*
-  Not only the user can provide value-related data (like diameter,
-  volume, etc.) but also they can plug in the cell "behavior" data.
-  Below, the existing behavior model of growth and division is
-  adopted. By inspection of the BioDynaMo source code, this behavior
-  assumes a cell to grow (by a constant volume rate); when its
-  diameter hits a critical value then it splits and creates a new cell.
-  Notably only the original cell (mother cell) can continue to grow and
-  divide, yet the new cell (daughter cell) simply lives on.
+  Simply create just one cell, and now update the resource manager by
+  adding the cell.
   */
-  // https://biodynamo.github.io/api/classbdm_1_1GrowthDivision.html
-  cell->AddBehavior(new GrowthDivision(max_diameter, volume_growth_rate));
+  rm->AddAgent(create_cell({mean_xyz, mean_xyz, mean_xyz}));
   /*
-  And now update the resource manager by adding the cell.
+  Only if the model is scaled up (see the command line options above) then
+  further cells are seeded at random positions in the simulation domain.
   */
-  rm->AddAgent(cell);
+  // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
+  ModelInitializer::CreateAgentsRandom(param->min_bound, param->max_bound,
+                                       scenario.Agents(1)-1, create_cell);
 
   /*
   Notably the simulation progresses for 1001 steps this time.
   */
-  sim.GetScheduler()->Simulate(1001);
+  scenario.Simulate(&sim, 1001);
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
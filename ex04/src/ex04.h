@@ -15,16 +15,53 @@
 #define EX04_H_
 
 #include "biodynamo.h"
+#include "scenario.h"
+#include "adaptive_parallelism_option.h"
+#include "profiler_option.h"
+#include "work_stealing_option.h"
 /*
-a user-defined header file is included here
+a header file of the user-defined behaviors (shared by the examples,
+see the 'common/src' folder) is included here
 */
-#include "my_growth_division.h"
+#include "cell_growth_division.h"
+#include "growth_events.h"
 
 namespace bdm {
 
+/*
+The user-defined growth & division behavior is a template that is here
+specialized on the agent type it acts upon, i.e., a BioDynaMo cell.
+*/
+using MyGrowthDivision = CellGrowthDivision<Cell>;
+
+/*
+Alternatively, the growth and division of all cells is predicted by a single
+operation that only handles the cells whose state changes in a time step
+(check the 'common/src/growth_events.h' header file), enabled with the
+command line option '--event-growth'.
+*/
+using MyGrowthEvents = GrowthEvents<Cell>;
+
 inline int ex04(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<bool>("event-growth", "false",
+                      "Grow and divide all cells by a single event-driven operation");
+  Scenario scenario("ex04", &clo);
+  // the optional features of this example, with their own command line
+  // options (check the header files of the options in 'common/src')
+  scenario.Add<AdaptiveParallelismOption>(&clo);
+  scenario.Add<ProfilerOption>(&clo);
+  scenario.Add<WorkStealingOption>(&clo);
+  const bool event_growth = clo.Get<bool>("event-growth");
+
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kClosed;
     param->min_bound =   0.0;
@@ -34,15 +71,25 @@ inline int ex04(int argc, const char* argv[]) {
     param->visualize_agents["Cell"] = { "diameter_", "volume_" };
     param->statistics = false;
     param->simulation_time_step = 1.0;
+    scenario.Apply(param);
   };
 
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
   auto* rm = sim.GetResourceManager();
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
   const Param* param = sim.GetParam();
 
+  MyGrowthEvents* growth_events = nullptr;
+  if (event_growth) {
+    growth_events = new MyGrowthEvents();
+    // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+    auto* op = new Operation("growth events");
+    op->AddOperationImpl(kCpu, growth_events);
+    sim.GetScheduler()->ScheduleOp(op);
+  }
+
   /*
   As with example "ex3", below we have some model parameters that will
   control the cell behavior.
@@ -52,22 +99,36 @@ inline int ex04(int argc, const char* argv[]) {
   real_t propability = 0.9;
   const real_t mean_xyz((param->max_bound+param->min_bound)/2);
 
-  // https://biodynamo.github.io/api/classbdm_1_1Cell.html
-  Cell* cell = new Cell({mean_xyz, mean_xyz, mean_xyz});
-  cell->SetDiameter(2.0);
-  cell->SetDensity(1.0);
-  // check the 'my_growth_division.h' header file
+  auto create_cell = [&](const Real3& xyz) {
+    // https://biodynamo.github.io/api/classbdm_1_1Cell.html
+    Cell* cell = new Cell(xyz);
+    cell->SetDiameter(2.0);
+    cell->SetDensity(1.0);
+    // check the 'common/src/cell_growth_division.h' header file
+    /*
+    Opposed to example "ex3", the user-defined growth & division behavior
+    grows a cell until diameter reaches a max, and then it probes (in every
+    successive time step) whether the probability to divide is below a
+    threshold. If that's true then it splits into two cells both of which
+    inherit this behavior; if not then nothing happens.
+    */
+    if (growth_events != nullptr) {
+      growth_events->Add(cell, {max_diameter, volume_growth_rate, propability});
+    } else {
+      cell->AddBehavior(new MyGrowthDivision(max_diameter, volume_growth_rate, propability));
+    }
+    return cell;
+  };
+  rm->AddAgent(create_cell({mean_xyz, mean_xyz, mean_xyz}));
   /*
-  Opposed to example "ex3", the user-defined growth & division behavior
-  grows a cell until diameter reaches a max, and then it probes (in every
-  successive time step) whether the probability to divide is below a
-  threshold. If that's true then it splits into two cells both of which
-  inherit this behavior; if not then nothing happens.
+  Only if the model is scaled up (see the command line options above) then
+  further cells are seeded at random positions in the simulation domain.
   */
-  cell->AddBehavior(new MyGrowthDivision(max_diameter, volume_growth_rate, propability));
-  rm->AddAgent(cell);
+  // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
+  ModelInitializer::CreateAgentsRandom(param->min_bound, param->max_bound,
+                                       scenario.Agents(1)-1, create_cell);
 
-  sim.GetScheduler()->Simulate(1001);
+  scenario.Simulate(&sim, 1001);
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
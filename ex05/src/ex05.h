@@ -15,17 +15,51 @@
 #define EX05_H_
 
 #include "biodynamo.h"
+#include "scenario.h"
+#include "adaptive_parallelism_option.h"
+#include "profiler_option.h"
+#include "work_stealing_option.h"
 /*
-two user-defined header files are included here
+two header files of the user-defined behaviors (shared by the examples,
+see the 'common/src' folder) are included here
 */
-#include "my_growth_division.h"
-#include "my_migration.h"
+#include "cell_growth_division.h"
+#include "growth_events.h"
+#include "cell_migration.h"
 
 namespace bdm {
 
+using MyGrowthDivision = CellGrowthDivision<Cell>;
+
+/*
+Alternatively, the growth and division of all cells is predicted by a single
+operation that only handles the cells whose state changes in a time step
+(check the 'common/src/growth_events.h' header file), enabled with the
+command line option '--event-growth'.
+*/
+using MyGrowthEvents = GrowthEvents<Cell>;
+using MyMigration = CellMigration<Cell>;
+
 inline int ex05(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<bool>("event-growth", "false",
+                      "Grow and divide all cells by a single event-driven operation");
+  Scenario scenario("ex05", &clo);
+  // the optional features of this example, with their own command line
+  // options (check the header files of the options in 'common/src')
+  scenario.Add<AdaptiveParallelismOption>(&clo);
+  scenario.Add<ProfilerOption>(&clo);
+  scenario.Add<WorkStealingOption>(&clo);
+  const bool event_growth = clo.Get<bool>("event-growth");
+
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kClosed;
     param->min_bound =   0.0;
@@ -35,41 +69,65 @@ inline int ex05(int argc, const char* argv[]) {
     param->visualize_agents["Cell"] = { "diameter_", "volume_" };
     param->statistics = false;
     param->simulation_time_step = 1.0;
+    scenario.Apply(param);
   };
 
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
   auto* rm = sim.GetResourceManager();
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
   const Param* param = sim.GetParam();
 
+  MyGrowthEvents* growth_events = nullptr;
+  if (event_growth) {
+    growth_events = new MyGrowthEvents();
+    // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+    auto* op = new Operation("growth events");
+    op->AddOperationImpl(kCpu, growth_events);
+    sim.GetScheduler()->ScheduleOp(op);
+  }
+
   real_t max_diameter = 3.0;
   real_t volume_growth_rate = 0.05;
   real_t propability = 0.5;
   real_t migration_rate = 1.0;
 
-  // https://biodynamo.github.io/api/classbdm_1_1Cell.html
+  auto create_cell = [&](const Real3& xyz) {
+    // https://biodynamo.github.io/api/classbdm_1_1Cell.html
+    Cell* cell = new Cell(xyz);
+    cell->SetDiameter(2.0);
+    cell->SetDensity(1.0);
+    /*
+    a user-defined behavior about the growth and division of a cell that
+    follows that of example "ex4";
+    however, check the 'cell_growth_division.h' header file for more info
+    */
+    if (growth_events != nullptr) {
+      growth_events->Add(cell, {max_diameter, volume_growth_rate, propability});
+    } else {
+      cell->AddBehavior(new MyGrowthDivision(max_diameter, volume_growth_rate, propability));
+    }
+    /*
+    a user-defined behavior that concerns the random movement of
+    cells in 3D space by probing first (in every successive time-step
+    of course) if the probability to move is below a threshold;
+    however, do check the 'cell_migration.h' header file for more info
+    */
+    cell->AddBehavior(new MyMigration(migration_rate, propability));
+    return cell;
+  };
   const real_t mean_xyz((param->max_bound+param->min_bound)/2);
-  Cell* cell = new Cell({mean_xyz, mean_xyz, mean_xyz});
-  cell->SetDiameter(2.0);
-  cell->SetDensity(1.0);
-  /*
-  a user-defined behavior about the growth and division of a cell that
-  follows that of example "ex4";
-  however, check the 'my_growth_division.h' header file for more info
-  */
-  cell->AddBehavior(new MyGrowthDivision(max_diameter, volume_growth_rate, propability));
+  rm->AddAgent(create_cell({mean_xyz, mean_xyz, mean_xyz}));
   /*
-  a user-defined behavior that concerns the random movement of
-  cells in 3D space by probing first (in every successive time-step
-  of course) if the probability to move is below a threshold;
-  however, do check the 'my_migration.h' header file for more info
+  Only if the model is scaled up (see the command line options above) then
+  further cells are seeded at random positions in the simulation domain.
   */
-  cell->AddBehavior(new MyMigration(migration_rate, propability));
-  rm->AddAgent(cell);
+  // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
+  ModelInitializer::CreateAgentsRandom(param->min_bound, param->max_bound,
+                                       scenario.Agents(1)-1, create_cell);
 
-  sim.GetScheduler()->Simulate(1001);
+  scenario.Simulate(&sim, 1001);
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
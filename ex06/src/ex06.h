@@ -15,13 +15,60 @@
 #define EX06_H_
 
 #include "biodynamo.h"
-#include "my_migration.h"
+#include "scenario.h"
+#include "async_visualization_option.h"
+#include "checkpoint_option.h"
+#include "profiler_option.h"
+#include "batched_migration.h"
+#include "cell_migration.h"
+#include "checkpoint.h"
+#include "dormant_tier.h"
 
 namespace bdm {
 
+/*
+This version of the migration behavior differs to that of example "ex5",
+in that it sticks a cell and makes it immobile in case it reaches the
+boundaries of the simulation domain. This option is a template parameter
+of the behavior (see the 'common/src/cell_migration.h' header file).
+With the command line option '--dormant-tier', a cell stuck on the boundary
+is moreover frozen, i.e., it no longer takes part in the mechanical
+interactions as it moves into the dormant tier (see the
+'common/src/dormant_tier.h' header file); this changes the model, as its
+neighbors no longer push it.
+*/
+using MyMigration = CellMigration<Cell, BoundaryMode::kStick, FreezeAction>;
+
+/*
+Alternatively, all cells migrate in a single operation over contiguous
+arrays of their positions (check the 'common/src/batched_migration.h'
+header file), enabled with the command line option '--batched-migration'.
+*/
+using MyBatchedMigration = BatchedMigration<BoundaryMode::kStick, FreezeAction>;
+
 inline int ex06(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<bool>("batched-migration", "false",
+                      "Migrate all cells in a single batched operation");
+  clo.AddOption<bool>("dormant-tier", "false",
+                      "Freeze the cells stuck on the boundary (changes the mechanics)");
+  Scenario scenario("ex06", &clo);
+  // the optional features of this example, with their own command line
+  // options (check the header files of the options in 'common/src')
+  auto* checkpoint_option = scenario.Add<CheckpointOption>(&clo);
+  scenario.Add<ProfilerOption>(&clo);
+  scenario.Add<AsyncVisualizationOption>(&clo);
+  const bool batched_migration = clo.Get<bool>("batched-migration");
+  const bool dormant_tier = clo.Get<bool>("dormant-tier");
+
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kClosed;
     param->min_bound =   0.0;
@@ -31,13 +78,64 @@ inline int ex06(int argc, const char* argv[]) {
     param->visualize_agents["Cell"] = { "diameter_", "volume_" };
     param->statistics = false;
     param->simulation_time_step = 1.0;
+    scenario.Apply(param);
   };
 
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
   const Param* param = sim.GetParam();
 
+  /*
+  The agent operations (i.e., the behaviors and the mechanical forces) are
+  executed only for the active cells, whereas the dormant ones are still
+  visible to their neighbors and exported for visualization.
+  */
+  DormantTier* dormant = nullptr;
+  auto active = L2F([&](Agent* agent) { return dormant->IsActive(agent); });
+  if (dormant_tier) {
+    dormant = new DormantTier();
+    // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+    auto* op = new Operation("dormant tier");
+    op->AddOperationImpl(kCpu, dormant);
+    sim.GetScheduler()->ScheduleOp(op, OpType::kPostSchedule);
+    // https://biodynamo.github.io/api/classbdm_1_1Scheduler.html
+    sim.GetScheduler()->SetAgentFilters({&active});
+  }
+  const FreezeAction freeze{dormant};
+
+  /*
+  The state of the simulation is checkpointed with the command line option
+  '--checkpoint' and resumed with '--restart' (check the
+  'common/src/checkpoint.h' header file): the kind of a cell records
+  whether it is dormant, and the migration behavior its parameters.
+  */
+  Checkpoint* checkpoint = checkpoint_option->GetCheckpoint();
+  checkpoint->SetKind(
+      [&](const Agent* agent) { return dormant != nullptr && dormant->IsDormant(agent); },
+      [&](int frozen) {
+        Cell* cell = new Cell();
+        if (frozen) freeze(cell);
+        return cell;
+      });
+  checkpoint->RegisterBehavior<MyMigration>("migration",
+      [](const MyMigration& b, const Agent&) {
+        return CheckpointParams{b.GetMigrationRate(), b.GetPropability()};
+      },
+      [&](const CheckpointParams& p) { return new MyMigration(p[0], p[1], freeze); });
+  if (batched_migration && checkpoint_option->IsCheckpointed()) {
+    Log::Fatal("ex06", "the batched migration cannot be checkpointed");
+  }
+
+  MyBatchedMigration* batched = nullptr;
+  if (batched_migration) {
+    batched = new MyBatchedMigration(freeze);
+    // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+    auto* op = new Operation("batched migration");
+    op->AddOperationImpl(kCpu, batched);
+    sim.GetScheduler()->ScheduleOp(op);
+  }
+
   /*
   User-defined function utlized below to generate cells provided some
   space vector, fixed properties and behavior.
@@ -46,18 +144,16 @@ inline int ex06(int argc, const char* argv[]) {
     // cell behavior model parameters
     real_t migration_rate = 1.0;
     real_t propability = 0.5;
-    bool stick2boundary = true;
 
     Cell* cell = new Cell();
     cell->SetDiameter(2.0);
     cell->SetDensity(1.0);
     cell->SetPosition(xyz);
-    /*
-    This version of the migration behavior function differs to that of example
-    "ex5". This behavior includes the option to stick a cell and make it
-    immobile in case it reaches the boundaries of the simulation domain.
-    */
-    cell->AddBehavior(new MyMigration(migration_rate, propability, stick2boundary));
+    if (batched != nullptr) {
+      batched->Add(cell, migration_rate, propability);
+    } else {
+      cell->AddBehavior(new MyMigration(migration_rate, propability, freeze));
+    }
     return cell;
   };
   /*
@@ -70,10 +166,12 @@ inline int ex06(int argc, const char* argv[]) {
   const Real3 center{mean_xyz, mean_xyz, mean_xyz};
   const real_t radius(0.45*(param->max_bound-param->min_bound));
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
-  ModelInitializer::CreateAgentsInSphereRndm(center,radius,
-                                             2222, generate_cluster_of_cells);
+  if (!checkpoint_option->Restart()) {
+    ModelInitializer::CreateAgentsInSphereRndm(center,radius,
+                                               scenario.Agents(2222), generate_cluster_of_cells);
+  }
 
-  sim.GetScheduler()->Simulate(5001);
+  scenario.Simulate(&sim, 5001);
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
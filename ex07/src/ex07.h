@@ -15,17 +15,100 @@
 #define EX07_H_
 
 #include "biodynamo.h"
+#include "scenario.h"
+#include "async_visualization_option.h"
+#include "checkpoint_option.h"
+#include "profiler_option.h"
 /*
-two user-defined header files are included here
+two header files of the user-defined behaviors (shared by the examples,
+see the 'common/src' folder) are included here
 */
-#include "my_growth.h"
-#include "my_migration.h"
+#include "batched_migration.h"
+#include "cell_growth.h"
+#include "cell_migration.h"
+#include "checkpoint.h"
+#include "dormant_tier.h"
+#include "growth_events.h"
 
 namespace bdm {
 
+/*
+Once a cell sticks to the domain boundary it stops moving anymore and then
+it starts growing until it reaches a maximum cell diameter value; check the
+'common/src/cell_growth.h' header file as well for more info about this
+cell behavior. With the command line option '--dormant-tier', the cell is
+frozen once grown, i.e., it no longer takes part in the mechanical
+interactions as it moves into the dormant tier (see the
+'common/src/dormant_tier.h' header file); this changes the model, as its
+neighbors no longer push it.
+*/
+using MyGrowth = CellGrowth<Cell, FreezeAction>;
+
+/*
+Alternatively, the growth of all cells is predicted by a single operation
+that only handles the cells whose state changes in a time step (check the
+'common/src/growth_events.h' header file), enabled with the command line
+option '--event-growth'.
+*/
+using MyGrowthEvents = GrowthEvents<Cell, FreezeAction>;
+
+/*
+Action performed by the migration behavior right after a cell sticks to the
+domain boundary.
+*/
+struct StartGrowth {
+  DormantTier* dormant = nullptr;
+  MyGrowthEvents* events = nullptr;
+
+  void operator()(Cell* cell) const {
+    // NOTE: not a good strategy to provide model parameter values
+    //       nested in the code; makes control of these parameters
+    //       a great challenge
+    real_t max_diameter = 4.0;
+    real_t volume_growth_rate = 0.1;
+    if (events != nullptr) {
+      events->Add(cell, {max_diameter, volume_growth_rate});
+    } else {
+      cell->AddBehavior(new MyGrowth(max_diameter, volume_growth_rate, FreezeAction{dormant}));
+    }
+  }
+};
+
+using MyMigration = CellMigration<Cell, BoundaryMode::kStick, StartGrowth>;
+
+/*
+Alternatively, all cells migrate in a single operation over contiguous
+arrays of their positions (check the 'common/src/batched_migration.h'
+header file), enabled with the command line option '--batched-migration'.
+*/
+using MyBatchedMigration = BatchedMigration<BoundaryMode::kStick, StartGrowth>;
+
 inline int ex07(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<bool>("batched-migration", "false",
+                      "Migrate all cells in a single batched operation");
+  clo.AddOption<bool>("dormant-tier", "false",
+                      "Freeze the cells grown on the boundary (changes the mechanics)");
+  clo.AddOption<bool>("event-growth", "false",
+                      "Grow all cells by a single event-driven operation");
+  Scenario scenario("ex07", &clo);
+  // the optional features of this example, with their own command line
+  // options (check the header files of the options in 'common/src')
+  auto* checkpoint_option = scenario.Add<CheckpointOption>(&clo);
+  scenario.Add<ProfilerOption>(&clo);
+  scenario.Add<AsyncVisualizationOption>(&clo);
+  const bool batched_migration = clo.Get<bool>("batched-migration");
+  const bool dormant_tier = clo.Get<bool>("dormant-tier");
+  const bool event_growth = clo.Get<bool>("event-growth");
+
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kClosed;
     param->min_bound =   0.0;
@@ -35,18 +118,86 @@ inline int ex07(int argc, const char* argv[]) {
     param->visualize_agents["Cell"] = { "diameter_", "volume_" };
     param->statistics = false;
     param->simulation_time_step = 1.0;
+    scenario.Apply(param);
   };
 
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
   const Param* param = sim.GetParam();
 
+  /*
+  The agent operations (i.e., the behaviors and the mechanical forces) are
+  executed only for the active cells, whereas the dormant ones are still
+  visible to their neighbors and exported for visualization.
+  */
+  DormantTier* dormant = nullptr;
+  auto active = L2F([&](Agent* agent) { return dormant->IsActive(agent); });
+  if (dormant_tier) {
+    dormant = new DormantTier();
+    // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+    auto* op = new Operation("dormant tier");
+    op->AddOperationImpl(kCpu, dormant);
+    sim.GetScheduler()->ScheduleOp(op, OpType::kPostSchedule);
+    // https://biodynamo.github.io/api/classbdm_1_1Scheduler.html
+    sim.GetScheduler()->SetAgentFilters({&active});
+  }
+
+  MyGrowthEvents* growth_events = nullptr;
+  if (event_growth) {
+    growth_events = new MyGrowthEvents(FreezeAction{dormant});
+    // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+    auto* op = new Operation("growth events");
+    op->AddOperationImpl(kCpu, growth_events);
+    sim.GetScheduler()->ScheduleOp(op);
+  }
+  const StartGrowth start_growth{dormant, growth_events};
+
+  /*
+  The state of the simulation is checkpointed with the command line option
+  '--checkpoint' and resumed with '--restart' (check the
+  'common/src/checkpoint.h' header file): the kind of a cell records
+  whether it is dormant, and the migration and growth behaviors their
+  parameters.
+  */
+  Checkpoint* checkpoint = checkpoint_option->GetCheckpoint();
+  checkpoint->SetKind(
+      [&](const Agent* agent) { return dormant != nullptr && dormant->IsDormant(agent); },
+      [&](int frozen) {
+        Cell* cell = new Cell();
+        if (frozen) FreezeAction{dormant}(cell);
+        return cell;
+      });
+  checkpoint->RegisterBehavior<MyMigration>("migration",
+      [](const MyMigration& b, const Agent&) {
+        return CheckpointParams{b.GetMigrationRate(), b.GetPropability()};
+      },
+      [&](const CheckpointParams& p) { return new MyMigration(p[0], p[1], start_growth); });
+  checkpoint->RegisterBehavior<MyGrowth>("growth",
+      [](const MyGrowth& b, const Agent&) {
+        return CheckpointParams{b.GetThreshold(), b.GetGrowthRate()};
+      },
+      [&](const CheckpointParams& p) { return new MyGrowth(p[0], p[1], FreezeAction{dormant}); });
+  if (batched_migration && checkpoint_option->IsCheckpointed()) {
+    Log::Fatal("ex07", "the batched migration cannot be checkpointed");
+  }
+  if (event_growth && checkpoint_option->IsCheckpointed()) {
+    Log::Fatal("ex07", "the event-driven growth cannot be checkpointed");
+  }
+
+  MyBatchedMigration* batched = nullptr;
+  if (batched_migration) {
+    batched = new MyBatchedMigration(start_growth);
+    // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+    auto* op = new Operation("batched migration");
+    op->AddOperationImpl(kCpu, batched);
+    sim.GetScheduler()->ScheduleOp(op);
+  }
+
   auto generate_cluster_of_cells = [&](const Real3& xyz) {
     // cell behavior model parameters
     real_t migration_rate = 1.0;
     real_t propability = 0.5;
-    bool stick2boundary = true;
 
     Cell* cell = new Cell();
     cell->SetDiameter(2.0);
@@ -58,16 +209,22 @@ inline int ex07(int argc, const char* argv[]) {
     stops moving anymore and then it starts growing until it reaches
     a maximum cell diameter value
     */
-    cell->AddBehavior(new MyMigration(migration_rate, propability, stick2boundary));
+    if (batched != nullptr) {
+      batched->Add(cell, migration_rate, propability);
+    } else {
+      cell->AddBehavior(new MyMigration(migration_rate, propability, start_growth));
+    }
     return cell;
   };
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
   const real_t mean_xyz((param->max_bound+param->min_bound)/2);
   const Real3 center{mean_xyz, mean_xyz, mean_xyz};
   const real_t radius(0.45*(param->max_bound-param->min_bound));
-  ModelInitializer::CreateAgentsInSphereRndm(center,radius,2222, generate_cluster_of_cells);
+  if (!checkpoint_option->Restart()) {
+    ModelInitializer::CreateAgentsInSphereRndm(center,radius,scenario.Agents(2222), generate_cluster_of_cells);
+  }
 
-  sim.GetScheduler()->Simulate(5001);
+  scenario.Simulate(&sim, 5001);
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
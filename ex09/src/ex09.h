@@ -15,24 +15,110 @@
 #define EX09_H_
 
 #include "biodynamo.h"
+#include "scenario.h"
+#include "async_visualization_option.h"
+#include "checkpoint_option.h"
+#include "profiler_option.h"
+#include "substance_option.h"
 /*
 Include a new header describing a new class of an agent (cell).
 */
 #include "my_cell.h"
-#include "my_growth.h"
-#include "my_migration.h"
+#include "core/behavior/secretion.h"
+#include "batched_migration.h"
+#include "batched_secretion.h"
+#include "cell_growth.h"
+#include "cell_migration.h"
+#include "checkpoint.h"
+#include "growth_events.h"
+#include "substances.h"
 
 namespace bdm {
 
+/*
+Once a cell sticks to the domain boundary it stops moving anymore and then
+it starts growing until it reaches a maximum cell diameter value; check the
+'common/src/cell_growth.h' header file as well for more info about this
+cell behavior.
+*/
+using MyGrowth = CellGrowth<Cell>;
+
+/*
+Alternatively, the growth of all cells is predicted by a single operation
+that only handles the cells whose state changes in a time step (check the
+'common/src/growth_events.h' header file), enabled with the command line
+option '--event-growth'.
+*/
+using MyGrowthEvents = GrowthEvents<Cell>;
+
+/*
+Action performed by the migration behavior right after a cell sticks to the
+domain boundary.
+*/
+struct StartGrowth {
+  MyGrowthEvents* events = nullptr;
+
+  void operator()(Cell* cell) const {
+    // NOTE: not a good strategy to provide model parameter values
+    //       nested in the code; makes control of these parameters
+    //       a great challenge
+    real_t max_diameter = 4.0;
+    real_t volume_growth_rate = 0.1;
+    if (events != nullptr) {
+      events->Add(cell, {max_diameter, volume_growth_rate});
+    } else {
+      cell->AddBehavior(new MyGrowth(max_diameter, volume_growth_rate));
+    }
+  }
+};
+
+using MyMigration = CellMigration<Cell, BoundaryMode::kStick, StartGrowth>;
+
+/*
+Alternatively, all cells migrate in a single operation over contiguous
+arrays of their positions (check the 'common/src/batched_migration.h'
+header file), enabled with the command line option '--batched-migration'.
+*/
+using MyBatchedMigration = BatchedMigration<BoundaryMode::kStick, StartGrowth>;
+
 enum Substances { kCytokine };
 
 inline int ex09(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<bool>("batched-migration", "false",
+                      "Migrate all cells in a single batched operation");
+  clo.AddOption<bool>("batched-secretion", "false",
+                      "Deposit the secretion of all cells in a single batched operation");
+  clo.AddOption<bool>("event-growth", "false",
+                      "Grow all cells by a single event-driven operation");
+  Scenario scenario("ex09", &clo);
+  // the optional features of this example, with their own command line
+  // options (check the header files of the options in 'common/src')
+  auto* checkpoint_option = scenario.Add<CheckpointOption>(&clo);
+  scenario.Add<ProfilerOption>(&clo);
+  scenario.Add<SubstanceOption>(&clo);
+  scenario.Add<AsyncVisualizationOption>(&clo);
+  const bool batched_migration = clo.Get<bool>("batched-migration");
+  const bool batched_secretion = clo.Get<bool>("batched-secretion");
+  const bool event_growth = clo.Get<bool>("event-growth");
+  // the profiler and the asynchronous visualization (if enabled) group the
+  // cells by their phenotype
+  scenario.SetAgentGroups("phenotype", [](const Agent* agent) {
+    return bdm_static_cast<const MyCell*>(agent)->GetPhenotype();
+  });
+
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
   /*
   Please note the important differences on the visualization parameter
   'param->visualize_agents["MyCell"]' compared to the previous example.
   */
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kClosed;
     param->min_bound =   0.0;
@@ -45,18 +131,43 @@ inline int ex09(int argc, const char* argv[]) {
     param->diffusion_method = "euler";
     param->statistics = false;
     param->simulation_time_step = 1.0;
+    scenario.Apply(param);
   };
 
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
   const Param* param = sim.GetParam();
 
+  MyGrowthEvents* growth_events = nullptr;
+  if (event_growth) {
+    growth_events = new MyGrowthEvents();
+    // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+    auto* op = new Operation("growth events");
+    op->AddOperationImpl(kCpu, growth_events);
+    sim.GetScheduler()->ScheduleOp(op);
+  }
+  const StartGrowth start_growth{growth_events};
+
+  MyBatchedMigration* batched = nullptr;
+  if (batched_migration) {
+    batched = new MyBatchedMigration(start_growth);
+    // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+    auto* op = new Operation("batched migration");
+    op->AddOperationImpl(kCpu, batched);
+    sim.GetScheduler()->ScheduleOp(op);
+  }
+
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
   real_t diffusion_rate = 0.0;
   real_t decay_rate = 0.05e-3;
-  int NxNxN = 51;
-  ModelInitializer::DefineSubstance(kCytokine, "TGF", diffusion_rate, decay_rate, NxNxN);
+  int NxNxN = scenario.Resolution(51);
+  /*
+  The substance does not diffuse, hence it is solved by an exact pointwise
+  decay of every voxel instead of the finite difference stencil; check the
+  'common/src/decay_grid.h' header file for more info.
+  */
+  DefineSubstance(kCytokine, "TGF", diffusion_rate, decay_rate, NxNxN);
   const BoundaryConditionType bc_type = BoundaryConditionType::kNeumann;
   ModelInitializer::AddBoundaryConditions(kCytokine, bc_type,
                                           std::make_unique<ConstantBoundaryCondition>(0));
@@ -64,29 +175,87 @@ inline int ex09(int argc, const char* argv[]) {
   const real_t domain_center = 0.5*(param->max_bound+param->min_bound);
   const real_t domain_delta = 0.5*(param->max_bound-param->min_bound);
 
+  // rates of the substance uptake (phenotype-1) and secretion (phenotype-2)
+  const real_t uptake_rate = -0.2e-3;
+  const real_t production_rate = 0.2e-3;
+  /*
+  Alternatively, all cells deposit their secretion (by their phenotype) in a
+  single operation (check the 'common/src/batched_secretion.h' header file),
+  enabled with the command line option '--batched-secretion'.
+  */
+  if (batched_secretion) {
+    auto* op = new Operation("batched secretion");
+    op->AddOperationImpl(kCpu, new BatchedSecretion("TGF", [=](const Agent* agent) {
+      const int phenotype = bdm_static_cast<const MyCell*>(agent)->GetPhenotype();
+      return phenotype == 1 ? uptake_rate : production_rate;
+    }));
+    sim.GetScheduler()->ScheduleOp(op);
+  }
+
+  /*
+  The state of the simulation is checkpointed with the command line option
+  '--checkpoint' and resumed with '--restart' (check the
+  'common/src/checkpoint.h' header file), together with the concentration
+  of the substance; the kind of a cell is its phenotype, which also sets
+  its secretion rate, while the migration and growth behaviors record
+  their parameters.
+  */
+  Checkpoint* checkpoint = checkpoint_option->GetCheckpoint();
+  checkpoint->SetKind(
+      [](const Agent* agent) { return bdm_static_cast<const MyCell*>(agent)->GetPhenotype(); },
+      [](int phenotype) {
+        MyCell* cell = new MyCell();
+        cell->SetPhenotype(phenotype);
+        return cell;
+      });
+  checkpoint->RegisterBehavior<MyMigration>("migration",
+      [](const MyMigration& b, const Agent&) {
+        return CheckpointParams{b.GetMigrationRate(), b.GetPropability()};
+      },
+      [&](const CheckpointParams& p) { return new MyMigration(p[0], p[1], start_growth); });
+  checkpoint->RegisterBehavior<MyGrowth>("growth",
+      [](const MyGrowth& b, const Agent&) {
+        return CheckpointParams{b.GetThreshold(), b.GetGrowthRate()};
+      },
+      [](const CheckpointParams& p) { return new MyGrowth(p[0], p[1]); });
+  if (!batched_secretion) {
+    checkpoint->RegisterBehavior<Secretion>("secretion",
+        [&](const Secretion&, const Agent& agent) {
+          const int phenotype = bdm_static_cast<const MyCell*>(&agent)->GetPhenotype();
+          return CheckpointParams{phenotype == 1 ? uptake_rate : production_rate};
+        },
+        [](const CheckpointParams& p) { return new Secretion("TGF", p[0]); });
+  }
+  if (batched_migration && checkpoint_option->IsCheckpointed()) {
+    Log::Fatal("ex09", "the batched migration cannot be checkpointed");
+  }
+  if (event_growth && checkpoint_option->IsCheckpointed()) {
+    Log::Fatal("ex09", "the event-driven growth cannot be checkpointed");
+  }
+  const bool restarted = checkpoint_option->Restart();
+
   /*
   User-defined function utlized below to generate cells. Note that these
   cells will be labelled (following the properties of the new cell type)
   as phenotype-1. This type of cells can only uptake "TGF".
   */
   auto generate_grid_of_cells = [&](const Real3& xyz) {
-    // cell behavior model parameters
-    real_t uptake_rate = -0.2e-3;
-
     MyCell* cell = new MyCell();
     cell->SetDiameter(4.0);
     cell->SetDensity(10.0);
     cell->SetPosition(xyz);
     cell->SetPhenotype(1);
-    cell->AddBehavior(new Secretion("TGF", uptake_rate));
+    if (!batched_secretion) cell->AddBehavior(new Secretion("TGF", uptake_rate));
     return cell;
   };
   /*
   Generate and add in the simulation engine 777 cells of phenotype-1.
   */
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
-  ModelInitializer::CreateAgentsRandom(domain_center-0.9*domain_delta,domain_center+0.9*domain_delta,
-                                       777, generate_grid_of_cells);
+  if (!restarted) {
+    ModelInitializer::CreateAgentsRandom(domain_center-0.9*domain_delta,domain_center+0.9*domain_delta,
+                                         scenario.Agents(777), generate_grid_of_cells);
+  }
 
   /*
   User-defined function utlized below to generate cells. Note that these
@@ -97,26 +266,30 @@ inline int ex09(int argc, const char* argv[]) {
     // cell behavior model parameters
     real_t migration_rate = 1.0;
     real_t propability = 0.5;
-    bool stick2boundary = true;
-    real_t production_rate = 0.2e-3;
 
     MyCell* cell = new MyCell();
     cell->SetDiameter(2.0);
     cell->SetDensity(1.0);
     cell->SetPosition(xyz);
     cell->SetPhenotype(2);
-    cell->AddBehavior(new MyMigration(migration_rate, propability, stick2boundary));
-    cell->AddBehavior(new Secretion("TGF", production_rate));
+    if (batched != nullptr) {
+      batched->Add(cell, migration_rate, propability);
+    } else {
+      cell->AddBehavior(new MyMigration(migration_rate, propability, start_growth));
+    }
+    if (!batched_secretion) cell->AddBehavior(new Secretion("TGF", production_rate));
     return cell;
   };
   /*
   Generate and add in the simulation engine 2222 cells of phenotype-2.
   */
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
-  ModelInitializer::CreateAgentsInSphereRndm({domain_center,domain_center,domain_center},0.85*domain_delta,
-                                             2222, generate_cluster_of_cells);
+  if (!restarted) {
+    ModelInitializer::CreateAgentsInSphereRndm({domain_center,domain_center,domain_center},0.85*domain_delta,
+                                               scenario.Agents(2222), generate_cluster_of_cells);
+  }
 
-  sim.GetScheduler()->Simulate(5001);
+  scenario.Simulate(&sim, 5001);
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
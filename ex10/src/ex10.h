@@ -15,6 +15,16 @@
 #define EX10_H_
 
 #include "biodynamo.h"
+#include "scenario.h"
+#include "async_visualization_option.h"
+#include "checkpoint_option.h"
+#include "profiler_option.h"
+#include "substance_option.h"
+#include "batched_secretion.h"
+#include "checkpoint.h"
+#include "mixed_precision_grid.h"
+#include "steady_state.h"
+#include "substances.h"
 #include "core/behavior/secretion.h"
 /*
 Include a new header describing a new class of an agent (cell).
@@ -30,8 +40,39 @@ relate with the (agent) cell behvaior later in the agent-based model.
 enum Substances { kCytokine };
 
 inline int ex10(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  clo.AddOption<real_t>("time-step", "0.5", "Time step of the simulation");
+  clo.AddOption<bool>("batched-secretion", "false",
+                      "Deposit the secretion of all cells in a single batched operation");
+  clo.AddOption<uint64_t>("steady-state", "0",
+                          "Solve the steady state of the substance every given steps (0 disables)");
+  clo.AddOption<bool>("validate-precision", "false",
+                      "Store the substance in float and report its deviation from double");
+  Scenario scenario("ex10", &clo);
+  // the optional features of this example, with their own command line
+  // options (check the header files of the options in 'common/src')
+  auto* checkpoint_option = scenario.Add<CheckpointOption>(&clo);
+  scenario.Add<ProfilerOption>(&clo);
+  auto* substance_option = scenario.Add<SubstanceOption>(&clo);
+  scenario.Add<AsyncVisualizationOption>(&clo);
+  const real_t time_step = clo.Get<real_t>("time-step");
+  const bool batched_secretion = clo.Get<bool>("batched-secretion");
+  const uint64_t steady_state = clo.Get<uint64_t>("steady-state");
+  const bool validate_precision = clo.Get<bool>("validate-precision");
+  // the profiler and the asynchronous visualization (if enabled) group the
+  // cells by their phenotype
+  scenario.SetAgentGroups("phenotype", [](const Agent* agent) {
+    return bdm_static_cast<const MyCell*>(agent)->GetPhenotype();
+  });
+
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kClosed;
     param->min_bound =   0.0;
@@ -43,16 +84,28 @@ inline int ex10(int argc, const char* argv[]) {
     param->calculate_gradients = false;
     param->diffusion_method = "euler";
     param->statistics = false;
-    param->simulation_time_step = 0.5;
+    param->simulation_time_step = time_step;
+    scenario.Apply(param);
   };
 
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
   const Param* param = sim.GetParam();
 
   const real_t DT = param->simulation_time_step;
-  int NxNxN = 91;
+  /*
+  The rates of the model are set for a time step of 0.5, which is close to
+  the stability limit of the explicit (Euler) finite differences of the
+  substance. The implicit ADI solver ('--diffusion-method=adi', check the
+  'common/src/adi_grid.h' header file) is stable for any time step, hence
+  the same model may be run with a 5-10 times larger one ('--time-step'),
+  the secretion of a time step being scaled accordingly (and the number of
+  time steps being reduced with '--steps').
+  */
+  const real_t DT0 = 0.5;
+  const real_t time_scale = DT/DT0;
+  int NxNxN = scenario.Resolution(91);
   const real_t domain_center = 0.5*(param->max_bound+param->min_bound);
   const real_t domain_delta = 0.5*(param->max_bound-param->min_bound);
 
@@ -61,10 +114,27 @@ inline int ex10(int argc, const char* argv[]) {
   that will be used by a finite differences numerical model to solve
   the reaction-diffusion problem (below the first parameter corresponds
   to the diffusion rate while the second to the decay rate' parameter) of
-  the corresponding substance.
+  the corresponding substance, by the solver selected with the command line
+  option '--diffusion-method' (check the 'common/src/substances.h' header
+  file). With '--substance-precision=float' the lattice is stored in single
+  precision, which halves the memory traffic of its time steps; the command
+  line option '--validate-precision' does so and computes the same time
+  steps in double precision as well, reporting the deviation at the end
+  (check the 'common/src/mixed_precision_grid.h' header file).
   */
-  // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
-  ModelInitializer::DefineSubstance(kCytokine, "TGF", 0.2/DT, 0.0/DT, NxNxN);
+  DefineSubstance(kCytokine, "TGF", 0.2/DT0, 0.0/DT0, NxNxN,
+                  validate_precision ? SubstancePrecision::kFloat
+                                     : substance_option->GetSubstancePrecision());
+  // https://biodynamo.github.io/api/classbdm_1_1ResourceManager.html
+  auto* mixed_grid = dynamic_cast<MixedPrecisionGrid*>(
+      sim.GetResourceManager()->GetDiffusionGrid(kCytokine));
+  if (validate_precision) {
+    if (mixed_grid != nullptr) {
+      mixed_grid->EnableValidation();
+    } else {
+      Log::Warning("ex10", "--validate-precision requires --diffusion-method=euler");
+    }
+  }
   /*
   Indicate the appropriate boundary condition to apply at the uniform
   lattice in order to solve the reaction-diffusion equation for the
@@ -77,28 +147,86 @@ inline int ex10(int argc, const char* argv[]) {
   // https://biodynamo.github.io/api/classbdm_1_1ConstantBoundaryCondition.html
                                           std::make_unique<ConstantBoundaryCondition>(0));
 
+  // rates of the substance secretion of the cells of either phenotype
+  const real_t uptake_rate = -1.0/DT0 * time_scale;
+  const real_t produce_rate = +0.1/DT0 * time_scale;
+  auto secretion_rate = [=](const Agent* agent) {
+    const int phenotype = bdm_static_cast<const MyCell*>(agent)->GetPhenotype();
+    return phenotype == 1 ? uptake_rate : produce_rate;
+  };
+  /*
+  Alternatively, all cells deposit their secretion (by their phenotype) in a
+  single operation (check the 'common/src/batched_secretion.h' header file),
+  enabled with the command line option '--batched-secretion'. As the cells
+  do not migrate, the operation sums their secretion per voxel once and then
+  reuses these sums, until a cell is pushed into another voxel.
+  */
+  if (batched_secretion) {
+    auto* op = new Operation("batched secretion");
+    op->AddOperationImpl(kCpu, new BatchedSecretion("TGF", secretion_rate));
+    sim.GetScheduler()->ScheduleOp(op);
+  }
+  /*
+  Since the sources and sinks of the substance do not move, its
+  concentration would tend to a steady state, which is computed directly
+  after the first time step (and then every given number of time steps, as
+  the cells are pushed around) with the command line option
+  '--steady-state' (check the 'common/src/steady_state.h' header file).
+  Note that without decay and with Neumann boundaries a steady state only
+  exists if the uptake balances the secretion, which is not the case for
+  the default phenotypes: the solver then logs a warning and leaves the
+  concentration to the time steps.
+  */
+  if (steady_state > 0) {
+    auto* solver = new SteadyState("TGF", secretion_rate, steady_state);
+    solver->Install(sim.GetScheduler());
+  }
+
+  /*
+  The state of the simulation is checkpointed with the command line option
+  '--checkpoint' and resumed with '--restart' (check the
+  'common/src/checkpoint.h' header file), together with the concentration
+  of the substance; the kind of a cell is its phenotype, which also sets
+  its secretion rate.
+  */
+  Checkpoint* checkpoint = checkpoint_option->GetCheckpoint();
+  checkpoint->SetKind(
+      [](const Agent* agent) { return bdm_static_cast<const MyCell*>(agent)->GetPhenotype(); },
+      [](int phenotype) {
+        MyCell* cell = new MyCell();
+        cell->SetPhenotype(phenotype);
+        return cell;
+      });
+  if (!batched_secretion) {
+    checkpoint->RegisterBehavior<Secretion>("secretion",
+        [&](const Secretion&, const Agent& agent) {
+          return CheckpointParams{secretion_rate(&agent)};
+        },
+        [](const CheckpointParams& p) { return new Secretion("TGF", p[0]); });
+  }
+  const bool restarted = checkpoint_option->Restart();
+
   /*
   User-defined function utlized below to generate cells. Note that these
   cells will be labelled (following the properties of the new cell type)
   as phenotype-1. This type of cells can only produce "TGF".
   */
   auto generate_grid_of_cells_1 = [&](const Real3& xyz) {
-    // cell behavior model parameters
-    real_t uptake_rate = -1.0/DT;
-
     MyCell* cell = new MyCell();
     cell->SetDiameter(1.0);
     cell->SetPosition(xyz);
     cell->SetPhenotype(1);
-    cell->AddBehavior(new Secretion("TGF", uptake_rate));
+    if (!batched_secretion) cell->AddBehavior(new Secretion("TGF", uptake_rate));
     return cell;
   };
   /*
   Generate and add in the simulation engine 100 cells of phenotype-1.
   */
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
-  ModelInitializer::CreateAgentsRandom(domain_center-0.9*domain_delta,domain_center+0.9*domain_delta,
-                                       5000, generate_grid_of_cells_1);
+  if (!restarted) {
+    ModelInitializer::CreateAgentsRandom(domain_center-0.9*domain_delta,domain_center+0.9*domain_delta,
+                                         scenario.Agents(5000), generate_grid_of_cells_1);
+  }
 
   /*
   User-defined function utlized below to generate cells. Note that these
@@ -106,24 +234,31 @@ inline int ex10(int argc, const char* argv[]) {
   as phenotype-2. This type of cells can only uptake "TGF".
   */
   auto generate_grid_of_cells_2 = [&](const Real3& xyz) {
-    // cell behavior model parameters
-    real_t produce_rate = +0.1/DT;
-
     MyCell* cell = new MyCell();
     cell->SetDiameter(2.0);
     cell->SetPosition(xyz);
     cell->SetPhenotype(2);
-    cell->AddBehavior(new Secretion("TGF", produce_rate));
+    if (!batched_secretion) cell->AddBehavior(new Secretion("TGF", produce_rate));
     return cell;
   };
   /*
   Generate and add in the simulation engine 1000 cells of phenotype-2.
   */
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
-  ModelInitializer::CreateAgentsRandom(domain_center-0.5*domain_delta,domain_center+0.5*domain_delta,
-                                       100, generate_grid_of_cells_2);
+  if (!restarted) {
+    ModelInitializer::CreateAgentsRandom(domain_center-0.5*domain_delta,domain_center+0.5*domain_delta,
+                                         scenario.Agents(100), generate_grid_of_cells_2);
+  }
+
+  scenario.Simulate(&sim, 2001);
 
-  sim.GetScheduler()->Simulate(2001);
+  if (validate_precision && mixed_grid != nullptr) {
+    std::cout << "Deviation of the float from the double lattice over "
+              << mixed_grid->GetValidatedSteps() << " steps: max "
+              << mixed_grid->GetMaxDeviation() << ", mean " << mixed_grid->GetMeanDeviation()
+              << " (largest concentration " << mixed_grid->GetMaxReference() << ")"
+              << std::endl;
+  }
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
@@ -15,15 +15,48 @@
 #define EX11_H_
 
 #include "my_utils.h"
+#include "scenario.h"
+#include "async_visualization_option.h"
+#include "profiler_option.h"
+#include "work_stealing_option.h"
 #include "my_cell.h"
-#include "my_migration.h"
-#include "my_growth_division.h"
+#include "my_contact_inhibition.h"
+#include "cell_growth_division.h"
+#include "cell_migration.h"
+#include "neighbor_index.h"
 
 namespace bdm {
 
+using MyMigration = CellMigration<MyCell>;
+/*
+The growth & division behavior is here specialized for cells that stop
+growing and dividing when adjacent to a cell of different phenotype (check
+the 'my_contact_inhibition.h' header file).
+*/
+using MyGrowthDivision = CellGrowthDivision<MyCell, HeterotypicContactInhibition>;
+
 inline int ex11(int argc, const char* argv[]) {
+  /*
+  The command line options shared by the examples allow to run the same
+  model at larger sizes and without visualization; check the
+  'common/src/scenario.h' header file for more info.
+  */
+  // https://biodynamo.github.io/api/classbdm_1_1CommandLineOptions.html
+  CommandLineOptions clo(argc, argv);
+  Scenario scenario("ex11", &clo);
+  // the optional features of this example, with their own command line
+  // options (check the header files of the options in 'common/src')
+  scenario.Add<ProfilerOption>(&clo);
+  scenario.Add<WorkStealingOption>(&clo);
+  scenario.Add<AsyncVisualizationOption>(&clo);
+  // the profiler and the asynchronous visualization (if enabled) group the
+  // cells by their phenotype
+  scenario.SetAgentGroups("phenotype", [](const Agent* agent) {
+    return bdm_static_cast<const MyCell*>(agent)->GetPhenotype();
+  });
+
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
-  auto set_parameters = [](Param* param) {
+  auto set_parameters = [&](Param* param) {
     param->use_progress_bar = true;
     param->bound_space = Param::BoundSpaceMode::kClosed;
     param->min_bound =   0.0;
@@ -33,10 +66,11 @@ inline int ex11(int argc, const char* argv[]) {
     param->visualize_agents["MyCell"] = { "diameter_", "volume_", "phenotype_" };
     param->statistics = false;
     param->simulation_time_step = 1.0;
+    scenario.Apply(param);
   };
 
   // https://biodynamo.github.io/api/classbdm_1_1Simulation.html
-  Simulation sim(argc, argv, set_parameters);
+  Simulation sim(&clo, set_parameters);
   // https://biodynamo.github.io/api/structbdm_1_1Param.html
   const Param* param = sim.GetParam();
 
@@ -63,7 +97,7 @@ inline int ex11(int argc, const char* argv[]) {
   Generate and add in the simulation engine a uniform cloud of 7x7x7
   cells of phenotype-1.
   */
-  const size_t agents_per_dim = 7;
+  const size_t agents_per_dim = scenario.PerDim(7);
   const real_t spacing = (param->max_bound-param->min_bound)/(agents_per_dim-1);
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
   ModelInitializer::Grid3D(agents_per_dim,spacing,
@@ -78,21 +112,36 @@ inline int ex11(int argc, const char* argv[]) {
   note that when a cell is adjacent to another cell (of different phenotype)
   then the former former simply stops from growing and dividing anymore.
   */
+  // maximum safe distance between cells; check what happens if you set it to zero
+  const real_t safe_distance = 4.0;
+  /*
+  An index of all cells (rebuilt at the beginning of every time step) where
+  the contact inhibition of the phenotype-2 cells searches for an adjacent
+  cell, stopping at the first one found. The cells of either phenotype are
+  kept apart, so that the search skips the (dense) phenotype-2 cluster;
+  check the 'common/src/neighbor_index.h' header file for more info.
+  */
+  auto* neighbors = new NeighborIndex(safe_distance, PhenotypePartition::kNumPartitions,
+                                      PhenotypePartition());
+  // https://biodynamo.github.io/api/structbdm_1_1Operation.html
+  auto* neighbors_op = new Operation("neighbor index");
+  neighbors_op->AddOperationImpl(kCpu, neighbors);
+  sim.GetScheduler()->ScheduleOp(neighbors_op, OpType::kPreSchedule);
+
   auto generate_cluster_of_cells = [&](const Real3& xyz) {
     // cell behavior model parameters
     real_t volume_growth_rate = 0.025;
     real_t division_propability = 1.0;
     // scaled mean diameter between the two cell types
     real_t smallest_distance = 1.8 * ((2.0+4.0)/2.0);
-    // maximum safe distance between cells; check what happens if you set it to zero
-    const real_t safe_distance = 4.0;
 
     MyCell* cell = new MyCell();
     cell->SetDiameter(2.0);
     cell->SetDensity(1.0);
     cell->SetPosition(xyz);
     cell->SetPhenotype(2);
-    cell->AddBehavior(new MyGrowthDivision(3.0, volume_growth_rate, division_propability, smallest_distance, safe_distance));
+    const HeterotypicContactInhibition inhibition(smallest_distance, safe_distance, neighbors);
+    cell->AddBehavior(new MyGrowthDivision(3.0, volume_growth_rate, division_propability, inhibition));
     return cell;
   };
   /*
@@ -104,9 +153,9 @@ inline int ex11(int argc, const char* argv[]) {
   const real_t radius(0.1*(param->max_bound-param->min_bound));
   // https://biodynamo.github.io/api/structbdm_1_1ModelInitializer.html
   ModelInitializer::CreateAgentsInSphereRndm(center,radius,
-                                             5, generate_cluster_of_cells);
+                                             scenario.Agents(5), generate_cluster_of_cells);
 
-  sim.GetScheduler()->Simulate(3001);
+  scenario.Simulate(&sim, 3001);
 
   std::cout << "Simulation completed successfully!" << std::endl;
   return 0;
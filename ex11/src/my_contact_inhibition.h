@@ -0,0 +1,122 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+#ifndef MY_CONTACT_INHIBITION_H_
+#define MY_CONTACT_INHIBITION_H_
+
+#include <algorithm>
+
+#include "my_utils.h"
+#include "my_cell.h"
+#include "neighbor_index.h"
+
+namespace bdm {
+
+/*
+Partition of the cells of a neighbor index by their phenotype (1 or 2).
+*/
+struct PhenotypePartition {
+  static constexpr int kNumPartitions = 2;
+
+  int operator()(const Agent* agent) const {
+    // all agents of this example are of type 'MyCell'
+    return bdm_static_cast<const MyCell*>(agent)->GetPhenotype() - 1;
+  }
+};
+
+/*
+Contact inhibition of the growth & division behavior: a cell is inhibited
+when it is adjacent to another cell of different phenotype.
+If a neighbor index is provided (see the 'common/src/neighbor_index.h'
+header file) then the search stops at the first adjacent cell found, and
+if the index is partitioned by phenotype (see 'PhenotypePartition' below)
+then it skips the cells of the same phenotype altogether; otherwise every
+neighbor within the safe distance is visited through the execution context
+of the simulation engine.
+*/
+class HeterotypicContactInhibition {
+  public:
+    HeterotypicContactInhibition() = default;
+    HeterotypicContactInhibition(real_t min_dist, real_t safe,
+                                 const NeighborIndex* index = nullptr)
+      : smallest_distance_(min_dist), safe_distance_(safe), index_(index) {}
+
+    bool operator()(MyCell* cell) const {
+      // check what happens if the safe distance is set to zero
+      if (safe_distance_ <= 0.0) return false;
+
+      if (index_ != nullptr) {
+        // a cell of different phenotype is adjacent if it is closer than
+        // both the safe and the smallest distance
+        const real_t d2 = pow2(std::min(safe_distance_, smallest_distance_));
+        if (index_->GetNumPartitions() > 1) {
+          // the index keeps the cells of every phenotype apart, hence only
+          // the cells of the other phenotypes are scanned
+          const int own = index_->GetPartition(cell);
+          for (int p = 0; p < index_->GetNumPartitions(); ++p) {
+            if (p != own && index_->FindAny(*cell, d2, p)) return true;
+          }
+          return false;
+        }
+        const int phenotype = cell->GetPhenotype();
+        const NeighborHit other_cell =
+            index_->FindAny(*cell, d2, [phenotype](Agent* agent, real_t) {
+              // all agents of this example are of type 'MyCell'
+              return bdm_static_cast<MyCell*>(agent)->GetPhenotype() != phenotype;
+            });
+        return static_cast<bool>(other_cell);
+      }
+
+      auto* ctxt = Simulation::GetActive()->GetExecutionContext();
+      AgentPointer<MyCell> other_cell = nullptr;
+
+      // custom function that will be used later as for how to
+      // define the search among cells in the simulation
+      auto search_functor_ = L2F([&](Agent* agent_,
+                                     real_t squared_distance_)
+      {
+        if (auto* neighbor_cell = dynamic_cast<const MyCell*>(agent_)) {
+          // only if cells do not share their phenotype ID
+          if (cell->GetPhenotype() != neighbor_cell->GetPhenotype()) {
+            // calculate the Euclidean distance between the cells
+            real_t d2 = SquaredDistance(cell->GetPosition(),
+                                        neighbor_cell->GetPosition());
+            // check if cells are very close enough
+            if (d2 < pow2(this->GetSmallestDistance())) {
+              // ...then, this is the neighboring cell
+              other_cell =
+                  AgentPointer<MyCell>(neighbor_cell->GetUid());
+            }
+          }
+        }
+      });
+
+      // execute the search process
+      ctxt->ForEachNeighbor(search_functor_, *cell, pow2(safe_distance_));
+      // if indeed this cell is adjacent to another cell (of different phenotype)
+      return (other_cell != nullptr);
+    }
+
+    real_t GetSmallestDistance() const { return smallest_distance_; }
+    real_t GetSafeDistance() const { return safe_distance_; }
+
+  private:
+    real_t smallest_distance_ = 1.0;
+    real_t safe_distance_ = 0.0;
+    // not owned; shared by the behaviors of all cells
+    const NeighborIndex* index_ = nullptr;
+};
+
+} // namespace bdm
+
+#endif // MY_CONTACT_INHIBITION_H_